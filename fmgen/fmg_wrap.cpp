@@ -14,16 +14,39 @@ extern "C" {
 #include "opna.h"
 };
 
+#ifdef PX68K_AUDIO_THREAD
+#include <pthread.h>
+
+// Scanline blocks collected before they are handed to the synthesis thread
+#define OPM_THREAD_BLOCKS 32
+#endif
+
 class MyOPM : public FM::OPM
 {
 public:
 	MyOPM();
-	virtual ~MyOPM() {}
+	virtual ~MyOPM();
 	void WriteIO(uint32_t adr, uint8_t data);
 	void Count2(uint32_t clock);
+#ifdef PX68K_AUDIO_THREAD
+	virtual void Flush();
+	void SetThreaded(bool on);
+	void Submit();
+#endif
 
 private:
 	virtual void Intr(bool);
+#ifdef PX68K_AUDIO_THREAD
+	void WaitIdle();
+	static void* ThreadMain(void* arg);
+
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	QueueBatch* busy;		// batch the thread is rendering, guarded by lock
+	bool running;
+	bool quit;
+#endif
 
 public:
 	int CurReg;
@@ -36,8 +59,113 @@ public:
 MyOPM::MyOPM()
 {
 	CurReg = 0;
+#ifdef PX68K_AUDIO_THREAD
+	pthread_mutex_init(&lock, NULL);
+	pthread_cond_init(&cond, NULL);
+	busy = NULL;
+	running = false;
+	quit = false;
+#endif
+}
+
+MyOPM::~MyOPM()
+{
+#ifdef PX68K_AUDIO_THREAD
+	SetThreaded(false);
+	pthread_cond_destroy(&cond);
+	pthread_mutex_destroy(&lock);
+#endif
 }
 
+#ifdef PX68K_AUDIO_THREAD
+// ----------------------------------------------------------
+//  Synthesis thread: renders detached batches into the mixing buffer
+//  while the CPU keeps emulating.  At most one batch is in flight,
+//  the next one is filled meanwhile.
+// ----------------------------------------------------------
+void* MyOPM::ThreadMain(void* arg)
+{
+	MyOPM* o = (MyOPM*)arg;
+
+	pthread_mutex_lock(&o->lock);
+	for (;;)
+	{
+		while (!o->busy && !o->quit)
+			pthread_cond_wait(&o->cond, &o->lock);
+		if (!o->busy)
+			break;
+		pthread_mutex_unlock(&o->lock);
+
+		o->Render(o->busy);
+
+		pthread_mutex_lock(&o->lock);
+		o->busy = NULL;
+		pthread_cond_broadcast(&o->cond);
+	}
+	pthread_mutex_unlock(&o->lock);
+	return NULL;
+}
+
+void MyOPM::WaitIdle()
+{
+	pthread_mutex_lock(&lock);
+	while (busy)
+		pthread_cond_wait(&cond, &lock);
+	pthread_mutex_unlock(&lock);
+}
+
+void MyOPM::Submit()
+{
+	QueueBatch* b;
+
+	if (!running)
+		return;
+
+	WaitIdle();
+	b = DetachQueue();
+	if (!b)
+		return;
+
+	pthread_mutex_lock(&lock);
+	busy = b;
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&lock);
+}
+
+void MyOPM::Flush()
+{
+	if (!running)
+	{
+		FM::OPM::Flush();
+		return;
+	}
+	Submit();
+	WaitIdle();
+}
+
+void MyOPM::SetThreaded(bool on)
+{
+	if (on == running)
+		return;
+
+	if (on)
+	{
+		quit = false;
+		if (!pthread_create(&thread, NULL, ThreadMain, this))
+			running = true;
+		return;
+	}
+
+	WaitIdle();
+	pthread_mutex_lock(&lock);
+	quit = true;
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&lock);
+	pthread_join(thread, NULL);
+	running = false;
+}
+#endif
+
 int MyOPM::StateAction(StateMem *sm, int load, int data_only)
 {
 	SFORMAT StateRegs[] =
@@ -62,7 +190,7 @@ void MyOPM::WriteIO(uint32_t adr, uint8_t data)
 			::ADPCM_SetClock((data>>5)&4);
 			::FDC_SetForceReady((data>>6)&1);
 		}
-		SetReg((int)CurReg, (int)data);
+		QueueReg((int)CurReg, (int)data);
 	}
 	else
 		CurReg = (int)data;
@@ -92,9 +220,14 @@ int OPM_StateAction(StateMem *sm, int load, int data_only)
 
 int OPM_Init(int clock)
 {
+	// at the native rate (or half of it) the chip steps envelopes and
+	// phases exactly once per sample and the output is resampled
+	static const int div[3] = { 0, 64, 128 };
+	int rate = (Config.OPMRate > 0 && Config.OPMRate < 3) ? clock / div[Config.OPMRate] : Config.SampleRate;
+
 	opm = new MyOPM();
 	if ( !opm ) return 0;
-	if ( !opm->Init(clock, 44100) ) {
+	if ( !opm->Init(clock, rate, Config.SampleRate) ) {
 		delete opm;
 		opm = NULL;
 		return 0;
@@ -128,9 +261,23 @@ void FASTCALL OPM_Write(uint32_t adr, uint8_t data)
 }
 
 
-void OPM_Update(int16_t *buffer, int length, uint8_t *pbsp, uint8_t *pbep)
+void OPM_Update(int32_t *buffer, int length)
+{
+	if ( !opm ) return;
+#ifdef PX68K_AUDIO_THREAD
+	opm->SetThreaded(Config.AudioThread != 0);
+#endif
+	opm->QueueMix((FM::ISample*)buffer, length);
+#ifdef PX68K_AUDIO_THREAD
+	if ( opm->QueuedBlocks() >= OPM_THREAD_BLOCKS )
+		opm->Submit();
+#endif
+}
+
+
+void OPM_Flush(void)
 {
-	if ( opm ) opm->Mix((int16_t*)buffer, length, pbsp, pbep);
+	if ( opm ) opm->Flush();
 }
 
 
@@ -172,6 +319,7 @@ YMF288::YMF288()
 {
 	CurReg[0] = 0;
 	CurReg[1] = 0;
+	CurCount = 0;
 	IntrFlag = 0;
 }
 
@@ -214,7 +362,7 @@ int M288_Init(int clock, const char* path)
 	ymf288b = new YMF288();
 	if ( (!ymf288a)||(!ymf288b) )
       goto error;
-   if ( (!ymf288a->Init(clock, 44100, path))||(!ymf288b->Init(clock, 44100, path)) )
+   if ( (!ymf288a->Init(clock, Config.SampleRate, path))||(!ymf288b->Init(clock, Config.SampleRate, path)) )
       goto error;
 	ymf288a->SetInt(1);
 	ymf288b->SetInt(0);
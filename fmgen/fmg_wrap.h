@@ -6,7 +6,8 @@
 int OPM_Init(int clock);
 void OPM_Cleanup(void);
 void OPM_Reset(void);
-void OPM_Update(int16_t *buffer, int length, uint8_t *pbsp, uint8_t *pbep);
+void OPM_Update(int32_t *buffer, int length);
+void OPM_Flush(void);
 void FASTCALL OPM_Write(uint32_t r, uint8_t v);
 uint8_t FASTCALL OPM_Read(void);
 void FASTCALL OPM_Timer(uint32_t step);
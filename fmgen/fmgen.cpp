@@ -247,7 +247,7 @@ int Chip::StateAction(StateMem *sm, int load, int data_only)
 //	åǶ̤ʬ
 //
 Chip::Chip()
-: ratio_(0), aml_(0), pml_(0), pmv_(0), optype_(TYPE_N)
+: ratio_(0), aml_(0), pml_(0), pmv_(0), optype_(TYPE_N), egoff_(false)
 {
 }
 
@@ -601,6 +601,8 @@ inline void Operator::SetEGRate(uint32_t rate)
 //	EG ׻
 void FM::Operator::EGCalc()
 {
+   EGPhase prev_phase = eg_phase_;
+
    eg_count_ = (2047 * 3) << FM_RATIOBITS;				// ##μȴϺƸ㲼
 
    if (eg_phase_ == ATTACK)
@@ -649,6 +651,9 @@ void FM::Operator::EGCalc()
       }
    }
    eg_curve_count_++;
+
+   if (eg_phase_ == OFF && prev_phase != OFF)
+      chip_->SetEGOff();
 }
 
 inline void FM::Operator::EGStep()
@@ -38,6 +38,7 @@ namespace FM
 	void StoreSample(ISample& dest, int data);
 
 	class Chip;
+	class OperatorBank;
 
 	//	Operator -------------------------------------------------------------
 	class Operator
@@ -160,6 +161,7 @@ namespace FM
 
 	//	friends --------------------------------------------------------------
 		friend class Channel4;
+		friend class OperatorBank;
 	};
 	
 	//	4-op Channel ---------------------------------------------------------
@@ -178,6 +180,7 @@ namespace FM
 		void SetFB(uint32_t fb);
 		void SetKCKF(uint32_t kc, uint32_t kf);
 		void SetAlgorithm(uint32_t algo);
+		int GetAlgorithm() { return algo_; }
 		int Prepare();
 		void KeyControl(uint32_t key);
 		void Reset();
@@ -203,6 +206,8 @@ namespace FM
 		static int 	kftable[64];
 
 
+		friend class OperatorBank;
+
 	public:
 		Operator op[4];
 	};
@@ -223,6 +228,11 @@ namespace FM
 		int		GetPMV() { return pmv_; }
 		uint32_t	GetRatio() { return ratio_; }
 
+		//	set when an operator's envelope reaches OFF while mixing
+		void	SetEGOff() { egoff_ = true; }
+		bool	GetEGOff() { return egoff_; }
+		void	ClearEGOff() { egoff_ = false; }
+
 		int StateAction(StateMem *sm, int load, int data_pnly);
 
 	private:
@@ -233,6 +243,7 @@ namespace FM
 		uint32_t	pml_;
 		int		pmv_;
 		OpType	optype_;
+		bool	egoff_;
 		uint32_t	multable_[4][16];
 	};
 }
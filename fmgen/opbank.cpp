@@ -0,0 +1,357 @@
+// ---------------------------------------------------------------------------
+//	Operators of several channels, mixed a sample at a time
+// ---------------------------------------------------------------------------
+
+#include <string.h>
+#include "misc.h"
+#include "fmgen.h"
+#include "opbank.h"
+#include "fmgeninl.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+//	as in fmgen.cpp
+#define IS2EC_SHIFT		((20 + FM_PGBITS) - 13)
+#define PG_SHIFT		(20 + FM_PGBITS - FM_OPSINBITS)
+#define IN_SHIFT		(PG_SHIFT - (2 + IS2EC_SHIFT))
+
+namespace FM
+{
+
+//	Modulation inputs and outputs of each algorithm, see
+//	Channel4::Calc(): bits 0-5 as OperatorBank::in_mask_, 8-11 as
+//	sum_mask_
+static const uint16_t algotable[8] =
+{
+	0x0800 | 0x02 | 0x04 | 0x20,
+	0x0800 | 0x01 | 0x02 | 0x20,
+	0x0800 | 0x02 | 0x08 | 0x20,
+	0x0800 | 0x04 | 0x10 | 0x20,
+	0x0a00 | 0x04 | 0x20,
+	0x0e00 | 0x01 | 0x04 | 0x08,
+	0x0e00 | 0x04,
+	0x0f00,
+};
+
+int OperatorBank::Load(Channel4* ch, int nch, uint32_t active, uint32_t lfo)
+{
+	int c, l, o, i;
+
+	lanes_ = 0;
+	lfo_   = -1;
+	for (c = 0; c < nch && lanes_ < BANK_LANES; c++)
+	{
+		if (!(active & (1 << c)))
+			continue;
+
+		l = lanes_++;
+		chan_[l] = c;
+		ch_[l]   = &ch[c];
+
+		if (lfo & (1 << c))
+			lfo_ = l;
+		lfo_mask_[l] = (lfo & (1 << c)) ? -1 : 0;
+		pmv_[l]      = 0;
+		pms_[l]      = ch[c].pms;
+		fb_[l]       = ch[c].fb;
+		fb_mask_[l]  = ch[c].fb < 31 ? -1 : 0;
+		for (i = 0; i < 6; i++)
+			in_mask_[i][l] = (algotable[ch[c].algo_] >> i) & 1 ? -1 : 0;
+		for (i = 0; i < 4; i++)
+			sum_mask_[i][l] = (algotable[ch[c].algo_] >> (8 + i)) & 1 ? -1 : 0;
+
+		for (o = 0; o < 4; o++)
+		{
+			Operator& op = ch[c].op[o];
+
+			pg_count_[o][l]     = op.pg_count_;
+			pg_diff_[o][l]      = op.pg_diff_;
+			pg_diff_lfo_[o][l]  = op.pg_diff_lfo_;
+			eg_count_[o][l]     = op.eg_count_;
+			eg_count_diff_[o][l] = op.eg_count_diff_;
+			eg_out_[o][l]       = op.eg_out_;
+			out_[o][l]          = op.out_;
+			out2_[o][l]         = op.out2_;
+			am_[o][l]           = 0;
+			ams_[o][l]          = op.ams_;
+		}
+	}
+
+	// the lanes left over never step their envelope and add nothing
+	for (l = lanes_; l < BANK_LANES; l++)
+	{
+		lfo_mask_[l] = pmv_[l] = fb_[l] = fb_mask_[l] = 0;
+		for (i = 0; i < 6; i++)
+			in_mask_[i][l] = 0;
+		for (o = 0; o < 4; o++)
+		{
+			sum_mask_[o][l] = 0;
+			pg_count_[o][l] = pg_diff_[o][l] = 0;
+			pg_diff_lfo_[o][l] = eg_count_diff_[o][l] = eg_out_[o][l] = 0;
+			out_[o][l] = out2_[o][l] = am_[o][l] = 0;
+			eg_count_[o][l] = 1;
+		}
+	}
+	return lanes_;
+}
+
+void OperatorBank::Store()
+{
+	for (int l = 0; l < lanes_; l++)
+	{
+		for (int o = 0; o < 4; o++)
+		{
+			Operator& op = ch_[l]->op[o];
+
+			op.pg_count_ = pg_count_[o][l];
+			op.eg_count_ = eg_count_[o][l];
+			op.out_      = out_[o][l];
+			op.out2_     = out2_[o][l];
+		}
+	}
+	lanes_ = 0;
+}
+
+//	The envelopes that have run out of count; EGCalc() works on the
+//	operator itself, the bank takes back what it changed
+//
+void OperatorBank::EGCalc()
+{
+	for (int o = 0; o < 4; o++)
+	{
+		for (int l = 0; l < lanes_; l++)
+		{
+			if (eg_count_[o][l] <= 0)
+			{
+				Operator& op = ch_[l]->op[o];
+
+				op.EGCalc();
+				eg_count_[o][l]      = op.eg_count_;
+				eg_count_diff_[o][l] = op.eg_count_diff_;
+				eg_out_[o][l]        = op.eg_out_;
+			}
+		}
+	}
+}
+
+void OperatorBank::Calc(Chip* chip, ISample* r)
+{
+	if (lfo_ >= 0)
+	{
+		uint32_t pml = chip->GetPML();
+		uint32_t aml = chip->GetAML();
+
+		aml_ = aml;
+		for (int l = 0; l < lanes_; l++)
+		{
+			pmv_[l] = pms_[l][pml] & lfo_mask_[l];
+#if defined(__AVX2__)
+			for (int o = 0; o < 4; o++)
+				am_[o][l] = ams_[o][l][aml] & lfo_mask_[l];
+#endif
+		}
+		// what CalcL() of the last channel leaves behind
+		chip->SetPMV(pms_[lfo_][pml]);
+	}
+	CalcLanes(r);
+}
+
+#if defined(__AVX2__)
+
+#define LD(p)		_mm256_loadu_si256((const __m256i*)(p))
+#define ST(p, v)	_mm256_storeu_si256((__m256i*)(p), (v))
+
+//	One operator of every lane.  in is the modulation input already
+//	shifted into sine table steps; returns the new output, old the one
+//	before
+//
+static inline __m256i OpAVX2(uint32_t* pg_count, const uint32_t* pg_diff,
+	const int32_t* pg_diff_lfo, __m256i pmv, const int32_t* eg_out,
+	const int32_t* am, int32_t* out, __m256i in, __m256i& old,
+	const uint32_t* sinetable, const int32_t* cltable)
+{
+	__m256i pg = LD(pg_count);
+	__m256i d  = _mm256_srai_epi32(_mm256_mullo_epi32(LD(pg_diff_lfo), pmv), 5);
+	ST(pg_count, _mm256_add_epi32(pg, _mm256_add_epi32(LD(pg_diff), d)));
+
+	__m256i pgin = _mm256_add_epi32(_mm256_srli_epi32(pg, PG_SHIFT), in);
+	pgin = _mm256_and_si256(pgin, _mm256_set1_epi32(FM_OPSINENTS - 1));
+
+	__m256i a = _mm256_i32gather_epi32((const int*)sinetable, pgin, 4);
+	a = _mm256_add_epi32(_mm256_add_epi32(a, LD(eg_out)), LD(am));
+	a = _mm256_min_epu32(a, _mm256_set1_epi32(FM_CLENTS - 1));
+
+	old = LD(out);
+	__m256i v = _mm256_i32gather_epi32((const int*)cltable, a, 4);
+	ST(out, v);
+	return v;
+}
+
+void OperatorBank::CalcLanes(ISample* r)
+{
+	const __m256i one = _mm256_set1_epi32(1);
+	__m256i lfo = LD(lfo_mask_);
+	__m256i pmv = LD(pmv_);
+	__m256i due = _mm256_setzero_si256();
+	__m256i in, old, n1, n2, n3, o0, fb, ret0;
+	int o;
+
+	for (o = 0; o < 4; o++)
+	{
+		__m256i c = _mm256_sub_epi32(LD(eg_count_[o]), LD(eg_count_diff_[o]));
+		ST(eg_count_[o], c);
+		due = _mm256_or_si256(due, _mm256_cmpgt_epi32(one, c));
+	}
+	if (!_mm256_testz_si256(due, due))
+		EGCalc();
+
+	o0 = LD(out_[0]);
+
+	// op2 from op0 and op1 as they were
+	in = _mm256_add_epi32(_mm256_and_si256(o0, LD(in_mask_[0])),
+		_mm256_and_si256(LD(out_[1]), LD(in_mask_[1])));
+	n2 = OpAVX2(pg_count_[2], pg_diff_[2], pg_diff_lfo_[2], pmv, eg_out_[2], am_[2],
+		out_[2], _mm256_srai_epi32(in, IN_SHIFT), old, Operator::sinetable, Operator::cltable);
+	ST(out2_[2], _mm256_blendv_epi8(old, LD(out2_[2]), lfo));
+
+	// op1 from op0
+	in = _mm256_and_si256(o0, LD(in_mask_[2]));
+	n1 = OpAVX2(pg_count_[1], pg_diff_[1], pg_diff_lfo_[1], pmv, eg_out_[1], am_[1],
+		out_[1], _mm256_srai_epi32(in, IN_SHIFT), old, Operator::sinetable, Operator::cltable);
+	ST(out2_[1], _mm256_blendv_epi8(old, LD(out2_[1]), lfo));
+
+	// op3 from op0 as it was and the new op1 and op2
+	in = _mm256_add_epi32(_mm256_and_si256(o0, LD(in_mask_[3])),
+		_mm256_add_epi32(_mm256_and_si256(n1, LD(in_mask_[4])),
+			_mm256_and_si256(n2, LD(in_mask_[5]))));
+	n3 = OpAVX2(pg_count_[3], pg_diff_[3], pg_diff_lfo_[3], pmv, eg_out_[3], am_[3],
+		out_[3], _mm256_srai_epi32(in, IN_SHIFT), old, Operator::sinetable, Operator::cltable);
+	ST(out2_[3], _mm256_blendv_epi8(old, LD(out2_[3]), lfo));
+
+	// op0 with self feedback
+	in = _mm256_add_epi32(o0, LD(out2_[0]));
+	ST(out2_[0], o0);
+	fb = _mm256_slli_epi32(in, 1 + IS2EC_SHIFT);
+	fb = _mm256_srai_epi32(_mm256_srav_epi32(fb, LD(fb_)), PG_SHIFT);
+	ret0 = OpAVX2(pg_count_[0], pg_diff_[0], pg_diff_lfo_[0], pmv, eg_out_[0], am_[0],
+		out_[0], _mm256_and_si256(fb, LD(fb_mask_)), old, Operator::sinetable, Operator::cltable);
+	// CalcFB() gives the output before, CalcFBL() the new one
+	ret0 = _mm256_blendv_epi8(o0, ret0, lfo);
+
+	ST(r, _mm256_add_epi32(
+		_mm256_add_epi32(_mm256_and_si256(ret0, LD(sum_mask_[0])), _mm256_and_si256(n1, LD(sum_mask_[1]))),
+		_mm256_add_epi32(_mm256_and_si256(n2, LD(sum_mask_[2])), _mm256_and_si256(n3, LD(sum_mask_[3])))));
+}
+
+#undef LD
+#undef ST
+
+#else
+
+//	Plain loops over the lanes for everything else, NEON included: the
+//	envelope counters in one pass, then each lane in turn with nothing
+//	in the way of the compiler vectorising the loop where the target
+//	has gathers
+
+//	One operator of a lane; in is the modulation input in sine table
+//	steps
+//
+static inline int32_t OpLane(uint32_t& pg_count, uint32_t pg_diff, int32_t pg_diff_lfo,
+	int32_t pmv, int32_t eg_out, int32_t am, int32_t in,
+	const uint32_t* sinetable, const int32_t* cltable)
+{
+	uint32_t pg = pg_count;
+	pg_count = pg + pg_diff + ((pg_diff_lfo * pmv) >> 5);
+
+	int pgin = (pg >> PG_SHIFT) + in;
+	uint32_t a = eg_out + sinetable[pgin & (FM_OPSINENTS - 1)] + am;
+	return cltable[a < FM_CLENTS ? a : FM_CLENTS - 1];
+}
+
+//	The lanes with the LFO terms in or, when none of the lanes has the
+//	LFO on, out
+//
+struct OperatorLanes
+{
+	template <bool LFO>
+	static void Calc(OperatorBank& b, ISample* r,
+		const uint32_t* sinetable, const int32_t* cltable);
+};
+
+template <bool LFO>
+void OperatorLanes::Calc(OperatorBank& b, ISample* r,
+	const uint32_t* sinetable, const int32_t* cltable)
+{
+	const int n = b.lanes_;
+	const uint32_t aml = b.aml_;
+
+	for (int l = 0; l < n; l++)
+	{
+		int32_t lfo = LFO ? b.lfo_mask_[l] : 0, pmv = LFO ? b.pmv_[l] : 0;
+		int32_t o0 = b.out_[0][l], o1 = b.out_[1][l], o2 = b.out_[2][l], o3 = b.out_[3][l];
+		int32_t n0, n1, n2, n3, in;
+
+		// op2 from op0 and op1 as they were
+		in = ((o0 & b.in_mask_[0][l]) + (o1 & b.in_mask_[1][l])) >> IN_SHIFT;
+		n2 = OpLane(b.pg_count_[2][l], b.pg_diff_[2][l], b.pg_diff_lfo_[2][l], pmv,
+			b.eg_out_[2][l], LFO ? b.ams_[2][l][aml] & lfo : 0, in, sinetable, cltable);
+
+		// op1 from op0
+		in = (o0 & b.in_mask_[2][l]) >> IN_SHIFT;
+		n1 = OpLane(b.pg_count_[1][l], b.pg_diff_[1][l], b.pg_diff_lfo_[1][l], pmv,
+			b.eg_out_[1][l], LFO ? b.ams_[1][l][aml] & lfo : 0, in, sinetable, cltable);
+
+		// op3 from op0 as it was and the new op1 and op2
+		in = ((o0 & b.in_mask_[3][l]) + (n1 & b.in_mask_[4][l]) + (n2 & b.in_mask_[5][l])) >> IN_SHIFT;
+		n3 = OpLane(b.pg_count_[3][l], b.pg_diff_[3][l], b.pg_diff_lfo_[3][l], pmv,
+			b.eg_out_[3][l], LFO ? b.ams_[3][l][aml] & lfo : 0, in, sinetable, cltable);
+
+		// op0 with self feedback
+		in = o0 + b.out2_[0][l];
+		in = (((in << (1 + IS2EC_SHIFT)) >> b.fb_[l]) >> PG_SHIFT) & b.fb_mask_[l];
+		n0 = OpLane(b.pg_count_[0][l], b.pg_diff_[0][l], b.pg_diff_lfo_[0][l], pmv,
+			b.eg_out_[0][l], LFO ? b.ams_[0][l][aml] & lfo : 0, in, sinetable, cltable);
+
+		// Calc() keeps the output before in out2_, CalcL() only for op0
+		b.out2_[0][l] = o0;
+		b.out2_[1][l] = (b.out2_[1][l] & lfo) | (o1 & ~lfo);
+		b.out2_[2][l] = (b.out2_[2][l] & lfo) | (o2 & ~lfo);
+		b.out2_[3][l] = (b.out2_[3][l] & lfo) | (o3 & ~lfo);
+		b.out_[0][l] = n0;
+		b.out_[1][l] = n1;
+		b.out_[2][l] = n2;
+		b.out_[3][l] = n3;
+
+		// CalcFB() gives the output before, CalcFBL() the new one
+		n0 = (n0 & lfo) | (o0 & ~lfo);
+		r[l] = (n0 & b.sum_mask_[0][l]) + (n1 & b.sum_mask_[1][l])
+			+ (n2 & b.sum_mask_[2][l]) + (n3 & b.sum_mask_[3][l]);
+	}
+}
+
+void OperatorBank::CalcLanes(ISample* r)
+{
+	// the lanes left over count nothing off, so all of them go at once
+	int32_t* eg_count = &eg_count_[0][0];
+	const int32_t* eg_count_diff = &eg_count_diff_[0][0];
+	int due = 0;
+
+	for (int i = 0; i < 4 * BANK_LANES; i++)
+	{
+		eg_count[i] -= eg_count_diff[i];
+		due |= eg_count[i] <= 0;
+	}
+	if (due)
+		EGCalc();
+
+	if (lfo_ >= 0)
+		OperatorLanes::Calc<true>(*this, r, Operator::sinetable, Operator::cltable);
+	else
+		OperatorLanes::Calc<false>(*this, r, Operator::sinetable, Operator::cltable);
+}
+
+#endif
+
+}	// namespace FM
@@ -0,0 +1,75 @@
+// ---------------------------------------------------------------------------
+//	Operators of several channels, mixed a sample at a time
+// ---------------------------------------------------------------------------
+
+#ifndef FM_OPBANK_H
+#define FM_OPBANK_H
+
+#include <stdint.h>
+
+#include "fmgen.h"
+
+namespace FM
+{
+	//	Copies the operators of up to BANK_LANES channels into one array
+	//	per field, a lane per channel, and renders a sample of all of them
+	//	at once: envelope counters, phase accumulators and the sine and
+	//	log-to-linear lookups run across the lanes, the algorithm is a set
+	//	of masks per lane.  Only an envelope that reaches its next step
+	//	leaves the lanes for Operator::EGCalc().
+	//
+	//	Load() takes the channels in, Calc() renders a sample per lane and
+	//	Store() hands the operators back; in between the bank holds the
+	//	operators' phase, envelope counter and output.  The result is the
+	//	same as Channel4::Calc(), or Channel4::CalcL() for the lanes with
+	//	the LFO on.
+	class OperatorBank
+	{
+	public:
+		enum
+		{
+			BANK_LANES = 8,
+		};
+
+		//	bit i of active and lfo stands for ch[i]; returns the lanes used
+		int		Load(Channel4* ch, int nch, uint32_t active, uint32_t lfo);
+		void	Store();
+		void	Calc(Chip* chip, ISample* r);
+		int		Channel(int lane) { return chan_[lane]; }
+
+	private:
+		friend struct OperatorLanes;
+
+		void	EGCalc();
+		void	CalcLanes(ISample* r);
+
+		int			lanes_;
+		int			lfo_;			// lane of the last channel with the LFO on, or -1
+		uint32_t	aml_;			// AM level of the sample, the plain loops look up am with it
+		int			chan_[BANK_LANES];
+		Channel4*	ch_[BANK_LANES];
+
+		//	per operator, op[0] to op[3] of each lane's channel
+		uint32_t	pg_count_[4][BANK_LANES];
+		uint32_t	pg_diff_[4][BANK_LANES];
+		int32_t		pg_diff_lfo_[4][BANK_LANES];
+		int32_t		eg_count_[4][BANK_LANES];
+		int32_t		eg_count_diff_[4][BANK_LANES];
+		int32_t		eg_out_[4][BANK_LANES];
+		int32_t		out_[4][BANK_LANES];
+		int32_t		out2_[4][BANK_LANES];
+		int32_t		am_[4][BANK_LANES];		// looked up ahead for the AVX2 path
+		const uint32_t*	ams_[4][BANK_LANES];
+
+		//	per lane; masks are all ones or zero
+		int32_t		lfo_mask_[BANK_LANES];
+		int32_t		pmv_[BANK_LANES];
+		const int*	pms_[BANK_LANES];
+		int32_t		fb_[BANK_LANES];
+		int32_t		fb_mask_[BANK_LANES];
+		int32_t		in_mask_[6][BANK_LANES];	// op2<-op0, op2<-op1, op1<-op0, op3<-op0, op3<-op1, op3<-op2
+		int32_t		sum_mask_[4][BANK_LANES];	// op0 to op3 into the channel output
+	};
+}
+
+#endif // FM_OPBANK_H
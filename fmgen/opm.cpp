@@ -4,6 +4,7 @@
 // ---------------------------------------------------------------------------
 
 #include <math.h>
+#include <string.h>
 #include "misc.h"
 #include "opm.h"
 #include "fmgeninl.h"
@@ -21,6 +22,16 @@ OPM::OPM()
 {
 	lfo_count_ = 0;
 	lfo_count_prev_ = ~0;
+	lfo_step_ = 0;
+	regcsm = 0;
+	queuing = false;
+	for (int i=0; i<2; i++)
+	{
+		batch[i].nqueue = batch[i].nblocks = 0;
+		batch[i].qsamples = batch[i].osamples = 0;
+		batch[i].buffer = NULL;
+	}
+	cur = &batch[0];
 	BuildLFOTable();
 	for (int i=0; i<8; i++)
 	{
@@ -64,10 +75,19 @@ int OPM::StateAction(StateMem *sm, int load, int data_only)
 		SFEND
 	};
 
+	Flush();
+
+	uint32_t r = rate;
 	int ret = Timer::StateAction(sm, load, data_only);
+	regcsm = regtc & 0x80;
 
 	ret &= PX68KSS_StateAction(sm, load, data_only, OPMStateRegs, "OPM", false);
 
+	// the chip keeps running at the rate the state was saved with
+	if (load && rate != r)
+		resampler.SetRate(rate, outrate);
+	ret &= resampler.StateAction(sm, load, data_only);
+
 	ret &= ch[0].StateAction(sm, load, data_only, "SCH0");
 	ret &= ch[1].StateAction(sm, load, data_only, "SCH1");
 	ret &= ch[2].StateAction(sm, load, data_only, "SCH2");
@@ -85,9 +105,9 @@ int OPM::StateAction(StateMem *sm, int load, int data_only)
 // ---------------------------------------------------------------------------
 //	
 //
-bool OPM::Init(uint32_t c, uint32_t rf)
+bool OPM::Init(uint32_t c, uint32_t rf, uint32_t outr)
 {
-	if (!SetRate(c, rf))
+	if (!SetRate(c, rf, outr))
 		return false;
 	
 	Reset();
@@ -100,12 +120,15 @@ bool OPM::Init(uint32_t c, uint32_t rf)
 // ---------------------------------------------------------------------------
 //	
 //
-bool OPM::SetRate(uint32_t c, uint32_t r)
+bool OPM::SetRate(uint32_t c, uint32_t r, uint32_t outr)
 {
+	Flush();
 	clock = c;
 	rate = r;
+	outrate = outr ? outr : r;
 
 	RebuildTimeTable();
+	resampler.SetRate(rate, outrate);
 	
 	return true;
 }
@@ -125,6 +148,7 @@ void OPM::SetChannelMask(uint32_t mask)
 void OPM::Reset()
 {
 	int i;
+	Flush();
 	for (i=0x0; i<0x100; i++) SetReg(i, 0);
 	SetReg(0x19, 0x80);
 	Timer::Reset();
@@ -156,11 +180,19 @@ void OPM::TimerA()
 {
 	if (regtc & 0x80)
 	{
-		for (int i=0; i<8; i++)
-		{
-			ch[i].KeyControl(0);
-			ch[i].KeyControl(0xf);
-		}
+		if (queuing)
+			Defer(OPM_CSMKEYON, 0);
+		else
+			CSMKeyOn();
+	}
+}
+
+void OPM::CSMKeyOn()
+{
+	for (int i=0; i<8; i++)
+	{
+		ch[i].KeyControl(0);
+		ch[i].KeyControl(0xf);
 	}
 }
 
@@ -169,6 +201,7 @@ void OPM::TimerA()
 //
 void OPM::SetVolume(int db)
 {
+	Flush();
 	db = FMGEN_MIN(db, 20);
 	if (db > -192)
 		fmvolume = (int)(16384.0f * powf(10, db / 40.0f));
@@ -222,7 +255,7 @@ void OPM::SetReg(uint32_t addr, uint32_t data)
 		break;
 		
 	case 0x08:					// KEYON
-		if (!(regtc & 0x80))
+		if (!regcsm)
 			ch[data & 7].KeyControl(data >> 3);
 		else
 		{
@@ -244,6 +277,7 @@ void OPM::SetReg(uint32_t addr, uint32_t data)
 
 	case 0x14:					// CSM, TIMER
 		SetTimerControl(data);
+		regcsm = data & 0x80;
 		break;
 	
 	case 0x18:					// LFRQ(lfo freq)
@@ -327,7 +361,7 @@ void OPM::SetParameter(uint32_t addr, uint32_t data)
 		break;
 		
 	case 3: // 60-7F TL
-		op->SetTL(data & 0x7f, (regtc & 0x80) != 0);
+		op->SetTL(data & 0x7f, regcsm != 0);
 		break;
 		
 	case 4: // 80-9F KS/AR
@@ -446,108 +480,260 @@ inline uint32_t OPM::Noise()
 	return noise;
 }
 
+#define IStoSample(s)	((Limit(s, 0xffff, -0x10000) * fmvolume) >> 14)
+
 // ---------------------------------------------------------------------------
-//	ΰ
+//	Channels to mix until the next register write
+//	odd bits - active, even bits - lfo
 //
-inline void OPM::MixSub(int activech, ISample** idest)
+uint32_t OPM::PrepareMix()
 {
-	if (activech & 0x4000)
-		*idest[0]  = ch[0].Calc();
-	if (activech & 0x1000)
-		*idest[1] += ch[1].Calc();
-	if (activech & 0x0400)
-		*idest[2] += ch[2].Calc();
-	if (activech & 0x0100)
-		*idest[3] += ch[3].Calc();
-	if (activech & 0x0040)
-		*idest[4] += ch[4].Calc();
-	if (activech & 0x0010)
-		*idest[5] += ch[5].Calc();
-	if (activech & 0x0004)
-		*idest[6] += ch[6].Calc();
-	if (activech & 0x0001)
+	uint32_t activech=0;
+	for (int i=0; i<8; i++)
+		activech = (activech << 2) | ch[i].Prepare();
+
+	// LFO ȷӥå = 1 ʤ LFO Ϥʤ?
+	if (reg01 & 0x02)
+		activech &= 0x5555;
+
+	// Algorithm 7 takes the feedback operator's output one sample later in
+	// Calc() than in CalcL(), so while any channel runs the LFO those
+	// channels keep to CalcL() as before
+	if (activech & 0xaaaa)
 	{
-		if (noisedelta & 0x80)
-			*idest[7] += ch[7].CalcN(Noise());
-		else
-			*idest[7] += ch[7].Calc();
+		for (int i=0; i<8; i++)
+		{
+			if (ch[i].GetAlgorithm() == 7)
+				activech |= (activech & (0x4000 >> (i * 2))) << 1;
+		}
 	}
+	return activech;
 }
 
-inline void OPM::MixSubL(int activech, ISample** idest)
+// ---------------------------------------------------------------------------
+//	Mixes up to nsamples; with stop_on_off it returns early after the
+//	sample in which an envelope reached OFF
+//
+int OPM::MixSamples(ISample*& dest, int nsamples, uint32_t activech, bool stop_on_off)
 {
-	if (activech & 0x4000)
-		*idest[0]  = ch[0].CalcL();
-	if (activech & 0x1000)
-		*idest[1] += ch[1].CalcL();
-	if (activech & 0x0400)
-		*idest[2] += ch[2].CalcL();
-	if (activech & 0x0100)
-		*idest[3] += ch[3].CalcL();
-	if (activech & 0x0040)
-		*idest[4] += ch[4].CalcL();
-	if (activech & 0x0010)
-		*idest[5] += ch[5].CalcL();
-	if (activech & 0x0004)
-		*idest[6] += ch[6].CalcL();
-	if (activech & 0x0001)
+	int i, l, n;
+	uint32_t active = 0, lfo = 0;
+	bool noise;
+	ISample r[OperatorBank::BANK_LANES];
+	ISample ibuf[8];
+	ISample* idest[8];
+	idest[0] = &ibuf[pan[0]];
+	idest[1] = &ibuf[pan[1]];
+	idest[2] = &ibuf[pan[2]];
+	idest[3] = &ibuf[pan[3]];
+	idest[4] = &ibuf[pan[4]];
+	idest[5] = &ibuf[pan[5]];
+	idest[6] = &ibuf[pan[6]];
+	idest[7] = &ibuf[pan[7]];
+
+	for (i = 0; i < 8; i++)
 	{
-		if (noisedelta & 0x80)
-			*idest[7] += ch[7].CalcLN(Noise());
-		else
-			*idest[7] += ch[7].CalcL();
+		active |= ((activech >> (14 - i * 2)) & 1) << i;
+		lfo    |= ((activech >> (15 - i * 2)) & 1) << i;
 	}
-}
+	// the noise channel stays on its own
+	noise = (activech & 0x0001) && (noisedelta & 0x80);
+	if (noise)
+		active &= ~0x80;
+	n = bank.Load(ch, 8, active, lfo);
 
-#define IStoSample(s)	((Limit(s, 0xffff, -0x10000) * fmvolume) >> 14)
+	for (i = 0; i < nsamples; i++)
+	{
+		ibuf[1] = ibuf[2] = ibuf[3] = 0;
+		LFO();
+		if (n)
+		{
+			bank.Calc(&chip, r);
+			for (l = 0; l < n; l++)
+				*idest[bank.Channel(l)] += r[l];
+		}
+		if (noise)
+			*idest[7] += (activech & 0x0002) ? ch[7].CalcLN(Noise()) : ch[7].CalcN(Noise());
+
+		dest[0] += IStoSample(ibuf[1] + ibuf[3]);
+		dest[1] += IStoSample(ibuf[2] + ibuf[3]);
+
+		dest += 2;
+		if (stop_on_off && chip.GetEGOff())
+		{
+			bank.Store();
+			return i + 1;
+		}
+	}
+	bank.Store();
+	return nsamples;
+}
 
 // ---------------------------------------------------------------------------
 //	 (stereo)
 //
-void OPM::Mix(int16_t* buffer, int nsamples, uint8_t* pbsp, uint8_t* pbep)
+void OPM::Mix(ISample* buffer, int nsamples)
 {
-	int i;
-	int16_t* dest;
-	
-	// odd bits - active, even bits - lfo
-	uint32_t activech=0;
-	for (i=0; i<8; i++)
-		activech = (activech << 2) | ch[i].Prepare();
+	uint32_t activech = PrepareMix();
 
 	if (activech & 0x5555)
+		MixSamples(buffer, nsamples, activech, false);
+}
+
+// ---------------------------------------------------------------------------
+//	Deferred mixing
+//
+//	Flush() reproduces what a Mix() call per QueueMix() would have output:
+//	the channel set is rebuilt at every register write and, after an
+//	envelope has switched a channel off, at the end of the QueueMix()
+//	block it happened in.
+//
+void OPM::Defer(uint32_t addr, uint32_t data)
+{
+	if (cur->nqueue == OPM_QUEUEENTS)
+		Flush();
+
+	QueuedReg& q = cur->queue[cur->nqueue++];
+	q.pos  = cur->qsamples;
+	q.addr = addr;
+	q.data = data;
+}
+
+void OPM::ApplyQueued(const QueuedReg& q)
+{
+	switch (q.addr)
 	{
-		// LFO ȷӥå = 1 ʤ LFO Ϥʤ?
-		if (reg01 & 0x02)
-			activech &= 0x5555;
-
-		// Mix
-		ISample ibuf[8];
-		ISample* idest[8];
-		idest[0] = &ibuf[pan[0]];
-		idest[1] = &ibuf[pan[1]];
-		idest[2] = &ibuf[pan[2]];
-		idest[3] = &ibuf[pan[3]];
-		idest[4] = &ibuf[pan[4]];
-		idest[5] = &ibuf[pan[5]];
-		idest[6] = &ibuf[pan[6]];
-		idest[7] = &ibuf[pan[7]];
-		
-		for (i = 0, dest = buffer; i < nsamples; i++)
+	case 0x14:
+		regcsm = q.data & 0x80;
+		break;
+
+	case OPM_CSMKEYON:
+		CSMKeyOn();
+		break;
+
+	case OPM_PREPARE:
+		PrepareMix();
+		break;
+
+	default:
+		SetReg(q.addr, q.data);
+		break;
+	}
+}
+
+void OPM::QueueReg(uint32_t addr, uint32_t data)
+{
+	queuing = true;
+	switch (addr)
+	{
+	case 0x10: case 0x11: case 0x12:	// timers run in CPU time
+		SetReg(addr, data);
+		return;
+
+	case 0x14:
+		SetTimerControl(data);
+		break;
+	}
+	Defer(addr, data);
+}
+
+void OPM::QueueMix(ISample* buffer, int nsamples)
+{
+	queuing = true;
+	if (nsamples <= 0)
+	{
+		Defer(OPM_PREPARE, 0);
+		return;
+	}
+
+	if (cur->osamples && (cur->nblocks == OPM_QUEUEBLOCKS || cur->buffer + cur->osamples * 2 != buffer))
+		Flush();
+	if (!cur->osamples)
+		cur->buffer = buffer;
+	cur->osamples += nsamples;
+	cur->qsamples += resampler.Active() ? resampler.Reserve(nsamples) : nsamples;
+	cur->blocks[cur->nblocks++] = cur->qsamples;
+}
+
+void OPM::Flush()
+{
+	Render(cur);
+}
+
+OPM::QueueBatch* OPM::DetachQueue()
+{
+	QueueBatch* b = cur;
+
+	if (!b->nqueue && !b->osamples)
+		return NULL;
+	cur = (b == &batch[0]) ? &batch[1] : &batch[0];
+	return b;
+}
+
+//	Renders nsamples chip samples to dest, through the resampler when the
+//	rates differ; returns the number rendered, see MixSamples()
+//
+int OPM::Output(ISample*& dest, int nsamples, uint32_t activech, bool stop_on_off, QueueBatch* bt)
+{
+	int i, n;
+
+	if (!resampler.Active())
+	{
+		if (activech & 0x5555)
+			return MixSamples(dest, nsamples, activech, stop_on_off);
+
+		dest += nsamples * 2;
+		return nsamples;
+	}
+
+	for (i = 0; i < nsamples; i += n)
+	{
+		ISample* buf = resampler.Buffer();
+
+		n = FMGEN_MIN(nsamples - i, (int)Resampler::RS_CHUNK);
+		memset(buf, 0, n * 2 * sizeof(ISample));
+		if (activech & 0x5555)
+			n = MixSamples(buf, n, activech, stop_on_off);
+		resampler.Write(n);
+		bt->osamples -= resampler.Read(dest, bt->osamples);
+
+		if (stop_on_off && chip.GetEGOff())
+			return i + n;
+	}
+	return nsamples;
+}
+
+void OPM::Render(QueueBatch* bt)
+{
+	ISample* dest = bt->buffer;
+	uint32_t pos = 0, end, activech;
+	int q = 0, b = 0;
+
+	while (pos < bt->qsamples)
+	{
+		while (q < bt->nqueue && bt->queue[q].pos == pos)
+			ApplyQueued(bt->queue[q++]);
+		end = (q < bt->nqueue) ? bt->queue[q].pos : bt->qsamples;
+
+		activech = PrepareMix();
+		chip.ClearEGOff();
+		pos += Output(dest, end - pos, activech, true, bt);
+		if (pos < end)
 		{
-			if ((uint8_t*)dest >= pbep)
-				dest = (int16_t *)pbsp;
-			ibuf[1] = ibuf[2] = ibuf[3] = 0;
-			if (activech & 0xaaaa)
-				LFO(), MixSubL(activech, idest);
-			else
-				LFO(), MixSub(activech, idest);
-
-			StoreSample(dest[0], IStoSample(ibuf[1] + ibuf[3]));
-			StoreSample(dest[1], IStoSample(ibuf[2] + ibuf[3]));
-
-			dest += 2;
+			while (bt->blocks[b] < pos)
+				b++;
+			Output(dest, bt->blocks[b] - pos, activech, false, bt);
+			pos = bt->blocks[b];
 		}
 	}
+	while (q < bt->nqueue)
+		ApplyQueued(bt->queue[q++]);
+
+	if (resampler.Active())
+		resampler.Read(dest, bt->osamples);
+
+	bt->nqueue = bt->nblocks = 0;
+	bt->qsamples = bt->osamples = 0;
 }
 
 }	// namespace FM
@@ -11,6 +11,8 @@
 #include "fmgen.h"
 #include "fmtimer.h"
 #include "psg.h"
+#include "resample.h"
+#include "opbank.h"
 
 namespace FM
 {
@@ -21,15 +23,56 @@ namespace FM
 		OPM();
 		virtual ~OPM() {}
 
-		bool	Init(uint32_t c, uint32_t r);
-		bool	SetRate(uint32_t c, uint32_t r);
+		bool	Init(uint32_t c, uint32_t r, uint32_t outr = 0);
+		bool	SetRate(uint32_t c, uint32_t r, uint32_t outr = 0);
 		void	Reset();
 		
 		void 	SetReg(uint32_t addr, uint32_t data);
 		uint32_t	GetReg(uint32_t addr);
 		uint32_t	ReadStatus() { return status & 0x03; }
 		
-		void 	Mix(int16_t* buffer, int nsamples, uint8_t* pbsp, uint8_t* pbep);
+		void 	Mix(ISample* buffer, int nsamples);
+
+		enum
+		{
+			OPM_QUEUEENTS = 4096,
+			OPM_QUEUEBLOCKS = 2048,
+		};
+
+		struct QueuedReg
+		{
+			uint32_t	pos;
+			uint16_t	addr;
+			uint8_t		data;
+		};
+
+		struct QueueBatch
+		{
+			QueuedReg	queue[OPM_QUEUEENTS];
+			uint32_t	blocks[OPM_QUEUEBLOCKS];	// end of each QueueMix() request
+			int		nqueue;
+			int		nblocks;
+			uint32_t	qsamples;	// chip samples to render
+			uint32_t	osamples;	// output samples reserved
+			ISample*	buffer;
+		};
+
+		//	Deferred mixing: QueueMix() only reserves output, register
+		//	writes made through QueueReg() are stamped with the number of
+		//	samples reserved so far and Flush() renders everything at once.
+		//	DetachQueue() hands the pending batch over so that Render() can
+		//	run it on another thread while the next one is being filled.
+		//	When the chip rate r differs from the output rate outr given to
+		//	Init(), the chip samples are converted on the way out; Mix()
+		//	always writes at the chip rate.  Output is added unclamped to
+		//	a contiguous 32-bit stereo buffer, saturating is up to the
+		//	caller.
+		void	QueueReg(uint32_t addr, uint32_t data);
+		void	QueueMix(ISample* buffer, int nsamples);
+		virtual void	Flush();
+		QueueBatch*	DetachQueue();
+		void	Render(QueueBatch* b);
+		int		QueuedBlocks() { return cur->nblocks; }
 		
 		void	SetVolume(int db);
 		void	SetChannelMask(uint32_t mask);
@@ -43,15 +86,21 @@ namespace FM
 		enum
 		{
 			OPM_LFOENTS = 512,
+			OPM_CSMKEYON = 0x100,		// queued Timer A key-on in CSM mode
+			OPM_PREPARE = 0x101,		// queued empty Mix()
 		};
-		
+
 		void	SetStatus(uint32_t bit);
 		void	ResetStatus(uint32_t bit);
 		void	SetParameter(uint32_t addr, uint32_t data);
 		void	TimerA();
+		void	CSMKeyOn();
+		void	Defer(uint32_t addr, uint32_t data);
+		void	ApplyQueued(const QueuedReg& q);
+		uint32_t	PrepareMix();
+		int		MixSamples(ISample*& dest, int nsamples, uint32_t activech, bool stop_on_off);
+		int		Output(ISample*& dest, int nsamples, uint32_t activech, bool stop_on_off, QueueBatch* bt);
 		void	RebuildTimeTable();
-		void	MixSub(int activech, ISample**);
-		void	MixSubL(int activech, ISample**);
 		void	LFO();
 		uint32_t	Noise();
 		
@@ -59,6 +108,7 @@ namespace FM
 
 		uint32_t	clock;
 		uint32_t	rate;
+		uint32_t	outrate;
 
 		uint32_t	pmd;
 		uint32_t	amd;
@@ -79,6 +129,7 @@ namespace FM
 		uint8_t	lfofreq;
 		uint8_t	status;
 		uint8_t	reg01;
+		uint8_t	regcsm;		// CSM bit of regtc as seen by the sound side
 
 		uint8_t	kc[8];
 		uint8_t	kf[8];
@@ -86,6 +137,12 @@ namespace FM
 
 		Channel4 ch[8];
 		Chip	chip;
+		OperatorBank	bank;
+
+		bool		queuing;	// driven through QueueReg()/QueueMix()
+		QueueBatch	batch[2];
+		QueueBatch*	cur;		// batch being filled
+		Resampler	resampler;
 
 		static void	BuildLFOTable();
 		static int amtable[4][OPM_LFOENTS];
@@ -0,0 +1,181 @@
+// ---------------------------------------------------------------------------
+//	Polyphase sample rate converter
+// ---------------------------------------------------------------------------
+
+#include <math.h>
+#include <string.h>
+#include "misc.h"
+#include "fmgen.h"
+#include "resample.h"
+#include "fmgeninl.h"
+
+namespace FM
+{
+
+Resampler::Resampler()
+{
+	inrate_ = outrate_ = 1;
+	memset(coef_, 0, sizeof(coef_));
+	Reset();
+}
+
+// ---------------------------------------------------------------------------
+//	Builds the filter table; the cutoff sits just below the lower of the
+//	two Nyquist frequencies
+//
+void Resampler::SetRate(uint32_t inrate, uint32_t outrate)
+{
+	const double pi = 3.14159265358979323846;
+	double fc = (outrate < inrate ? double(outrate) / inrate : 1.0) * 0.45;
+
+	inrate_  = inrate;
+	outrate_ = outrate;
+	Reset();
+
+	for (int p = 0; p < RS_PHASES; p++)
+	{
+		double h[RS_TAPS], sum = 0;
+		int t;
+
+		for (t = 0; t < RS_TAPS; t++)
+		{
+			// distance of tap t from the (delayed) output position
+			double d = double(p) / RS_PHASES + (RS_TAPS - 1 - t) - RS_TAPS / 2;
+			double x = 2 * pi * fc * d;
+			double w = d / (RS_TAPS / 2);
+
+			h[t] = (d == 0) ? 1.0 : sin(x) / x;
+			h[t] *= 0.42 + 0.5 * cos(pi * w) + 0.08 * cos(2 * pi * w);
+			sum += h[t];
+		}
+		for (t = 0; t < RS_TAPS; t++)
+			coef_[p][t] = int16_t(floor(h[t] / sum * (1 << 14) + 0.5));
+	}
+}
+
+void Resampler::Reset()
+{
+	ipos_ = frac_ = written_ = 0;
+	rpos_ = rfrac_ = rwritten_ = 0;
+	memset(hist_, 0, sizeof(hist_));
+}
+
+// ---------------------------------------------------------------------------
+//	Reserves nout output samples, returns the number of input samples
+//	that have to be written before they can all be read
+//
+uint32_t Resampler::Reserve(uint32_t nout)
+{
+	uint32_t last, need;
+	uint64_t t;
+
+	if (!nout)
+		return 0;
+
+	last = rpos_ + uint32_t((rfrac_ + uint64_t(nout - 1) * inrate_) / outrate_);
+	need = (int32_t(last + 1 - rwritten_) > 0) ? last + 1 - rwritten_ : 0;
+	rwritten_ += need;
+
+	t = rfrac_ + uint64_t(nout) * inrate_;
+	rpos_ += uint32_t(t / outrate_);
+	rfrac_ = uint32_t(t % outrate_);
+	return need;
+}
+
+// ---------------------------------------------------------------------------
+//	Takes n samples from Buffer() into the history, saturated to 16 bits
+//
+void Resampler::Write(int n)
+{
+	for (int i = 0; i < n; i++)
+	{
+		uint32_t idx = (written_ + i) & (RS_HISTORY - 1);
+		int16_t l = (int16_t)Limit(buf_[i * 2], 0x7fff, -0x8000);
+		int16_t r = (int16_t)Limit(buf_[i * 2 + 1], 0x7fff, -0x8000);
+
+		hist_[0][idx] = l;
+		hist_[1][idx] = r;
+		if (idx < RS_TAPS)
+		{
+			hist_[0][idx + RS_HISTORY] = l;
+			hist_[1][idx + RS_HISTORY] = r;
+		}
+	}
+	written_ += n;
+}
+
+// ---------------------------------------------------------------------------
+//	Adds up to nout converted samples to dest, as many as the written
+//	input allows; returns the number added
+//
+int Resampler::Read(int32_t*& dest, int nout)
+{
+	int n;
+
+	for (n = 0; n < nout && int32_t(ipos_ - written_) < 0; n++)
+	{
+		uint32_t start = (ipos_ - (RS_TAPS - 1)) & (RS_HISTORY - 1);
+		const int16_t* c = coef_[frac_ * RS_PHASES / outrate_];
+		const int16_t* l = &hist_[0][start];
+		const int16_t* r = &hist_[1][start];
+		int32_t al = 1 << 13, ar = 1 << 13;
+
+		// plain multiply-accumulate so that the compiler can vectorise it
+		for (int t = 0; t < RS_TAPS; t++)
+		{
+			al += l[t] * c[t];
+			ar += r[t] * c[t];
+		}
+
+		dest[0] += al >> 14;
+		dest[1] += ar >> 14;
+		dest += 2;
+
+		frac_ += inrate_;
+		while (frac_ >= outrate_)
+		{
+			frac_ -= outrate_;
+			ipos_++;
+		}
+	}
+	return n;
+}
+
+int Resampler::StateAction(StateMem *sm, int load, int data_only)
+{
+	uint32_t inrate = inrate_, outrate = outrate_;
+
+	SFORMAT StateRegs[] =
+	{
+		SFVAR(inrate_),
+		SFVAR(outrate_),
+		SFVAR(ipos_),
+		SFVAR(frac_),
+		SFVAR(written_),
+		SFARRAY16N(hist_[0], RS_HISTORY + RS_TAPS, "hist_l"),
+		SFARRAY16N(hist_[1], RS_HISTORY + RS_TAPS, "hist_r"),
+
+		SFEND
+	};
+
+	// states from before the resampler lack it
+	int ret = PX68KSS_StateAction(sm, load, data_only, StateRegs, "RSMP", true);
+
+	if (load)
+	{
+		if (ret < 0 || inrate_ != inrate || outrate_ != outrate)
+		{
+			// none saved or saved with other rates; start afresh
+			inrate_  = inrate;
+			outrate_ = outrate;
+			Reset();
+		}
+		// everything reserved has been read before a state is taken
+		rpos_     = ipos_;
+		rfrac_    = frac_;
+		rwritten_ = written_;
+	}
+	return ret != 0;
+}
+
+}	// namespace FM
@@ -0,0 +1,68 @@
+// ---------------------------------------------------------------------------
+//	Polyphase sample rate converter
+// ---------------------------------------------------------------------------
+
+#ifndef FM_RESAMPLE_H
+#define FM_RESAMPLE_H
+
+#include <stdint.h>
+
+#include "common.h"
+
+namespace FM
+{
+	//	Converts interleaved 16-bit stereo from the chip rate to the output
+	//	rate with a windowed-sinc FIR.  The output is delayed by half the
+	//	filter length.
+	//
+	//	Reserve() is called when output is requested and returns how many
+	//	input samples have to be rendered before it can be read.  Rendering
+	//	goes into Buffer(), Write() takes it in and Read() adds the
+	//	converted samples to a 32-bit output buffer.
+	class Resampler
+	{
+	public:
+		enum
+		{
+			RS_TAPS = 32,			// filter length in input samples
+			RS_PHASES = 256,		// sub-sample positions in the table
+			RS_HISTORY = 2048,		// input history, power of two
+			RS_CHUNK = 1024,		// most input samples per Write()
+		};
+
+		Resampler();
+
+		void	SetRate(uint32_t inrate, uint32_t outrate);
+		void	Reset();
+		bool	Active() { return inrate_ != outrate_; }
+
+		uint32_t	Reserve(uint32_t nout);
+		int32_t*	Buffer() { return buf_; }
+		void	Write(int n);
+		int		Read(int32_t*& dest, int nout);
+
+		int		StateAction(StateMem *sm, int load, int data_only);
+
+	private:
+		uint32_t	inrate_;
+		uint32_t	outrate_;
+
+		// next output to read: newest input it uses and sub-sample position
+		uint32_t	ipos_;
+		uint32_t	frac_;
+		uint32_t	written_;
+
+		// the same for the next output to reserve
+		uint32_t	rpos_;
+		uint32_t	rfrac_;
+		uint32_t	rwritten_;
+
+		int16_t		coef_[RS_PHASES][RS_TAPS];
+		// L/R history; the first RS_TAPS entries are repeated at the end
+		// so that every filter window is contiguous
+		int16_t		hist_[2][RS_HISTORY + RS_TAPS];
+		int32_t		buf_[RS_CHUNK * 2];
+	};
+}
+
+#endif // FM_RESAMPLE_H
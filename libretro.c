@@ -24,6 +24,8 @@
 #include "libretro/timer.h"
 #include "libretro/mouse.h"
 #include "libretro/winui.h"
+#include "libretro/rewind.h"
+#include "libretro/bootcache.h"
 #include "fmgen/fmg_wrap.h"
 #include "m68000/m68000.h"
 #include "x68k/adpcm.h"
@@ -84,12 +86,14 @@ uint16_t	VLINE_TOTAL = 567;
 uint32_t	VLINE = 0;
 uint32_t	vline = 0;
 
-#define SOUNDRATE 44100.0
+#define SOUNDRATE ((double)Config.SampleRate)
 #define SNDSZ round(SOUNDRATE / FRAMERATE)
 
 static int firstcall          = 1;
 
 static uint32_t old_ram_size     = 0;
+/* retro_serialize_size(), 0 until laid out again */
+static size_t serialize_size     = 0;
 static int old_clkdiv         = 0;
 
 static int oldrw=0,oldrh      = 0;
@@ -128,6 +132,15 @@ static int PARAMCOUNT     = 0;
 static uint8_t DispFrame  = 0;
 static int FrameSkipCount = 0;
 static int FrameSkipQueue = 0;
+
+/* Auto Frame Skip driven by the frontend's audio buffer */
+#define FRAMESKIP_MAX 30 /* most frames skipped in a row */
+static bool audio_buff_status_set   = false;
+static bool audio_buff_active       = false;
+static unsigned audio_buff_occupancy = 0;
+static bool audio_buff_underrun     = false;
+static unsigned frameskip_counter   = 0;
+static bool update_audio_latency    = false;
 static int ClkUsed        = 0;
 
 uint32_t retrow           = 800;
@@ -142,7 +155,7 @@ unsigned int total_usec   = (unsigned int) -1;
 static int16_t soundbuf[1024 * 2];
 static int soundbuf_size;
 
-uint16_t *videoBuffer;
+pixel_t *videoBuffer;
 
 enum {
    menu_out,
@@ -167,6 +180,11 @@ struct retro_vfs_interface_info vfs_iface_info;
 static unsigned no_content;
 
 static bool opt_rumble_enabled = false;
+static bool opt_incremental_states = false;
+static bool opt_compress_states = false;
+static int opt_boot_cache = 0; /* frames after a cold start, 0 = off */
+static int opt_state_benchmark = 0; /* runs, 0 = off */
+static bool state_benchmark_pending = false;
 
 #define MAX_DISKS 10
 
@@ -214,7 +232,7 @@ static struct retro_input_descriptor input_descs_p1[] = {
    { 0, RETRO_DEVICE_JOYPAD, 0, RETRO_DEVICE_ID_JOYPAD_R2, "R2 - Touroku" },
    { 0, RETRO_DEVICE_JOYPAD, 0, RETRO_DEVICE_ID_JOYPAD_L2, "L2 - Menu" },
    { 0, RETRO_DEVICE_JOYPAD, 0, RETRO_DEVICE_ID_JOYPAD_R3, "R3" },
-   { 0, RETRO_DEVICE_JOYPAD, 0, RETRO_DEVICE_ID_JOYPAD_L3, "L3" },
+   { 0, RETRO_DEVICE_JOYPAD, 0, RETRO_DEVICE_ID_JOYPAD_L3, "L3 - Rewind" },
 };
 static struct retro_input_descriptor input_descs_p2[] = {
    { 1, RETRO_DEVICE_JOYPAD, 0, RETRO_DEVICE_ID_JOYPAD_A, "A" },
@@ -299,23 +317,23 @@ static int libretro_supports_midi_output = 0;
 static struct retro_midi_interface midi_cb = { 0 };
 static bool libretro_supports_option_categories = 0;
 
-void midi_out_short_msg(size_t msg)
+void midi_out_short_msg(size_t msg, uint32_t delta)
 {
    if (libretro_supports_midi_output && midi_cb.output_enabled())
    {
-      midi_cb.write(msg         & 0xFF, 0); /* status byte */
+      midi_cb.write(msg         & 0xFF, delta); /* status byte */
       midi_cb.write((msg >> 8)  & 0xFF, 0); /* note no. */
       midi_cb.write((msg >> 16) & 0xFF, 0); /* velocity */
    }
 }
 
-void midi_out_long_msg(uint8_t *s, size_t len)
+void midi_out_long_msg(uint8_t *s, size_t len, uint32_t delta)
 {
    if (libretro_supports_midi_output && midi_cb.output_enabled())
    {
       int i;
       for (i = 0; i < len; i++)
-         midi_cb.write(s[i], 0);
+         midi_cb.write(s[i], i ? 0 : delta);
    }
 }
 
@@ -901,6 +919,7 @@ static  void WinX68k_Cleanup(void)
 {
 	if (IPL)
 		free(IPL);
+	PX68KSS_FreePages();
 	if (MEM)
 		free(MEM);
 	if (FONT)
@@ -1220,6 +1239,33 @@ void retro_set_environment(retro_environment_t cb)
 #endif
 }
 
+static void audio_buff_status_cb(bool active, unsigned occupancy, bool underrun_likely)
+{
+   audio_buff_active    = active;
+   audio_buff_occupancy = occupancy;
+   audio_buff_underrun  = underrun_likely;
+}
+
+/* (Un)registers the audio buffer status callback to match the frame
+ * skip setting; the frontend is asked for a matching latency from
+ * retro_run */
+static void setup_frameskip(void)
+{
+   struct retro_audio_buffer_status_callback cb;
+
+   cb.callback = (Config.FrameRate == 7) ? audio_buff_status_cb : NULL;
+   audio_buff_status_set = environ_cb(RETRO_ENVIRONMENT_SET_AUDIO_BUFFER_STATUS_CALLBACK, &cb)
+      && cb.callback;
+   if (!audio_buff_status_set && cb.callback && log_cb)
+      log_cb(RETRO_LOG_WARN, "[libretro]: no audio buffer status, Auto Frame Skip falls back to frame timing.\n");
+
+   audio_buff_active    = false;
+   audio_buff_occupancy = 0;
+   audio_buff_underrun  = false;
+   frameskip_counter    = 0;
+   update_audio_latency = true;
+}
+
 static void update_variables(int running)
 {
    int i = 0, snd_opt = 0;
@@ -1305,6 +1351,8 @@ static void update_variables(int running)
       else if (strcmp(var.value, "12MB") == 0)
          value = 12;
 
+      if (Config.ram_size != (value * 1024 * 1024))
+         serialize_size = 0;
       Config.ram_size = (value * 1024 * 1024);
    }
 
@@ -1345,6 +1393,30 @@ static void update_variables(int running)
       }
    }
 
+   var.key    = "px68k_sample_rate";
+   var.value  = NULL;
+
+   if (!running && environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      snd_opt = atoi(var.value);
+      /* the sound buffers are sized for at most 48 kHz */
+      if (snd_opt >= 22050 && snd_opt <= 48000)
+         Config.SampleRate = snd_opt;
+   }
+
+   var.key    = "px68k_opm_rate";
+   var.value  = NULL;
+
+   if (!running && environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (!strcmp(var.value, "Output Rate"))
+         Config.OPMRate = 0;
+      else if (!strcmp(var.value, "Native"))
+         Config.OPMRate = 1;
+      else if (!strcmp(var.value, "Half Native"))
+         Config.OPMRate = 2;
+   }
+
 #ifndef NO_MERCURY
    var.key    = "px68k_mercury_vol";
    var.value  = NULL;
@@ -1477,6 +1549,7 @@ static void update_variables(int running)
 
    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
    {
+      int temp = Config.FrameRate;
       if (!strcmp(var.value, "Auto Frame Skip"))
          Config.FrameRate = 7;
       else if (!strcmp(var.value, "1/2 Frame"))
@@ -1499,8 +1572,17 @@ static void update_variables(int running)
          Config.FrameRate = 60;
       else if (!strcmp(var.value, "Full Frame"))
          Config.FrameRate = 1;
+
+      if (Config.FrameRate != temp && (Config.FrameRate == 7 || temp == 7))
+         setup_frameskip();
    }
 
+   var.key    = "px68k_frameskip_threshold";
+   var.value  = NULL;
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      Config.FrameSkipThreshold = strcmp(var.value, "Underrun") ? atoi(var.value) : 0;
+
    var.key     = "px68k_adjust_frame_rates";
    var.value   = NULL;
 
@@ -1527,6 +1609,105 @@ static void update_variables(int running)
          Config.AudioDesyncHack = 1;
    }
 
+   var.key   = "px68k_reduced_resolution";
+   var.value = NULL;
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      int temp = Config.ReducedRes;
+      if (!strcmp(var.value, "disabled"))
+         Config.ReducedRes = 0;
+      else if (!strcmp(var.value, "Half Width"))
+         Config.ReducedRes = 1;
+      else if (!strcmp(var.value, "Half Height"))
+         Config.ReducedRes = 2;
+      else if (!strcmp(var.value, "Half Width and Height"))
+         Config.ReducedRes = 3;
+      if (Config.ReducedRes != temp)
+         TVRAM_SetAllDirty();
+   }
+
+#ifdef PX68K_AUDIO_THREAD
+   var.key   = "px68k_audio_thread";
+   var.value = NULL;
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (!strcmp(var.value, "disabled"))
+         Config.AudioThread = 0;
+      else if (!strcmp(var.value, "enabled"))
+         Config.AudioThread = 1;
+   }
+#endif
+
+   var.key   = "px68k_incremental_states";
+   var.value = NULL;
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (!strcmp(var.value, "disabled"))
+         opt_incremental_states = false;
+      else if (!strcmp(var.value, "enabled"))
+         opt_incremental_states = true;
+   }
+
+   var.key   = "px68k_compress_states";
+   var.value = NULL;
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (!strcmp(var.value, "disabled"))
+         opt_compress_states = false;
+      else if (!strcmp(var.value, "enabled"))
+         opt_compress_states = true;
+   }
+
+   {
+      size_t rewind_budget = 0;
+      int rewind_step      = 1;
+
+      var.key   = "px68k_rewind_buffer";
+      var.value = NULL;
+
+      if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      {
+         if (strcmp(var.value, "disabled"))
+            rewind_budget = (size_t)atoi(var.value) * 1024 * 1024;
+      }
+
+      var.key   = "px68k_rewind_granularity";
+      var.value = NULL;
+
+      if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+         rewind_step = atoi(var.value);
+
+      Rewind_Setup(rewind_budget, rewind_step);
+   }
+
+   var.key   = "px68k_boot_cache";
+   var.value = NULL;
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (!strcmp(var.value, "disabled"))
+         opt_boot_cache = 0;
+      else
+         opt_boot_cache = atoi(var.value);
+   }
+
+   var.key   = "px68k_state_benchmark";
+   var.value = NULL;
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      int runs = strcmp(var.value, "disabled") ? atoi(var.value) : 0;
+
+      /* runs once on the next frame each time it is set */
+      if (runs && runs != opt_state_benchmark)
+         state_benchmark_pending = true;
+      opt_state_benchmark = runs;
+   }
+
    var.key   = "px68k_text_off";
    var.value = NULL;
 
@@ -1615,7 +1796,7 @@ int StateAction(StateMem *sm, int load, int data_only)
 {
    SFORMAT StateRegs[] =
    {
-      SFARRAYN(MEM, MEM_SIZE, "RAM"),
+      SFPAGESN(MEM_Pages, "RAM"),
       SFARRAYN(SRAM, 16384, "SRAM"),
       SFVAR(ICount),
       SFVAR(ClkUsed),
@@ -1630,6 +1811,9 @@ int StateAction(StateMem *sm, int load, int data_only)
 
    int ret = 0, count = 0;
 
+   /* what lies beyond the installed RAM is mostly untouched */
+   MEM_Pages.keep = Config.ram_size;
+
    ret = PX68KSS_StateAction(sm, load, data_only, StateRegs, "MAIN", false);
    ret &= m68000_StateAction(sm, load, data_only);
    ret &= GVRAM_StateAction(sm, load, data_only);
@@ -1660,56 +1844,123 @@ int StateAction(StateMem *sm, int load, int data_only)
    return ret;
 }
 
-static bool UsingFastSavestates(void)
+static int SavestateContext(void)
 {
    int flags;
    if (environ_cb(RETRO_ENVIRONMENT_GET_SAVESTATE_CONTEXT, &flags))
-      return ((flags == RETRO_SAVESTATE_CONTEXT_RUNAHEAD_SAME_INSTANCE) ||
-            ((flags == RETRO_SAVESTATE_CONTEXT_RUNAHEAD_SAME_BINARY)));
+      return flags;
+   return RETRO_SAVESTATE_CONTEXT_UNKNOWN;
+}
+
+/* Only the same build loads these; rollback netplay states go to
+ * peers running the same binary */
+static bool UsingFastSavestates(void)
+{
+   int flags = SavestateContext();
+   return ((flags == RETRO_SAVESTATE_CONTEXT_RUNAHEAD_SAME_INSTANCE) ||
+         (flags == RETRO_SAVESTATE_CONTEXT_RUNAHEAD_SAME_BINARY) ||
+         (flags == RETRO_SAVESTATE_CONTEXT_ROLLBACK_NETPLAY));
+}
+
+/* The raw layout keeps the host byte order, so it never leaves the
+ * machine */
+static bool UsingRawSavestates(void)
+{
+   int flags = SavestateContext();
+   return ((flags == RETRO_SAVESTATE_CONTEXT_RUNAHEAD_SAME_INSTANCE) ||
+         (flags == RETRO_SAVESTATE_CONTEXT_RUNAHEAD_SAME_BINARY));
+}
+
+/* Only states that may end up on disk are worth packing, and only when
+ * asked: the frontend's rewind saves in the normal context too, and
+ * runahead in the unknown one where the context is not reported */
+static bool UsingPackedSavestates(void)
+{
+   int flags;
+
+   if (!opt_compress_states)
+      return false;
+
+   flags = SavestateContext();
+   return ((flags == RETRO_SAVESTATE_CONTEXT_NORMAL) ||
+         (flags == RETRO_SAVESTATE_CONTEXT_UNKNOWN));
+}
+
+/* Video is off for the frames the frontend runs without showing them */
+static bool FrameIsShown(void)
+{
+   int enable = 3;
+
+   if (!environ_cb(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &enable))
+      return true;
+   return (enable & 1) != 0;
+}
+
+/* Only the instance that took a delta state holds its base */
+static bool UsingDeltaStates(void)
+{
+   int flags;
+   if (opt_incremental_states && environ_cb(RETRO_ENVIRONMENT_GET_SAVESTATE_CONTEXT, &flags))
+      return (flags == RETRO_SAVESTATE_CONTEXT_RUNAHEAD_SAME_INSTANCE);
    return false;
 }
 
+/* The layout only depends on the build and the machine set up in
+ * pre_main(), so it is walked once and cached.  Paged memory counts
+ * at its largest and the packed container at its worst; most states
+ * come out much smaller. */
 size_t retro_serialize_size(void)
 {
    StateMem st;
 
+   if (serialize_size)
+      return serialize_size;
+
    st.data           = NULL;
    st.loc            = 0;
    st.len            = 0;
    st.malloced       = 0;
    st.initial_malloc = 0;
    st.fastsavestates = 0;
+   st.sizeonly       = 1;
+   st.fixedsize      = 0;
+   st.delta          = 0;
+   st.raw            = 0;
+   st.compress       = 1;
 
    if (!PX68KSS_SaveSM(&st, 0, 0, NULL, NULL, NULL))
       return 0;
 
-   free(st.data);
-
-   return st.len;
+   serialize_size = st.len;
+   return serialize_size;
 }
 
 bool retro_serialize(void *data, size_t size)
 {
    StateMem st;
-   bool ret          = false;
-   uint8_t *_dat     = (uint8_t*)malloc(size);
-
-   if (!_dat)
-      return false;
 
-   st.data           = _dat;
+   /* straight into the frontend's buffer */
+   st.data           = (uint8_t*)data;
    st.loc            = 0;
    st.len            = 0;
    st.malloced       = size;
    st.initial_malloc = 0;
    st.fastsavestates = UsingFastSavestates();
+   st.sizeonly       = 0;
+   st.fixedsize      = 1;
+   st.delta          = UsingDeltaStates();
+   st.raw            = UsingRawSavestates();
+   st.compress       = UsingPackedSavestates();
 
-   ret = PX68KSS_SaveSM(&st, 0, 0, NULL, NULL, NULL);
+   if (!PX68KSS_SaveSM(&st, 0, 0, NULL, NULL, NULL))
+      return false;
 
-   memcpy(data, st.data, size);
-   free(st.data);
+   /* whatever follows a packed state is zeroed, so that frontends
+    * which store the whole buffer compress it to next to nothing */
+   if (st.compress && st.len < size)
+      memset((uint8_t*)data + st.len, 0, size - st.len);
 
-   return ret;
+   return true;
 }
 
 bool retro_unserialize(const void *data, size_t size)
@@ -1723,6 +1974,11 @@ bool retro_unserialize(const void *data, size_t size)
    st.malloced       = 0;
    st.initial_malloc = 0;
    st.fastsavestates = UsingFastSavestates();
+   st.sizeonly       = 0;
+   st.fixedsize      = 0;
+   st.delta          = 0;
+   st.raw            = 0;
+   st.compress       = 0;
 
    ret = PX68KSS_LoadSM(&st, 0, 0);
 
@@ -1797,7 +2053,11 @@ void retro_init(void)
 {
    struct retro_log_callback log;
    struct retro_rumble_interface rumble;
+#ifdef PX68K_XRGB8888
+   enum retro_pixel_format fmt = RETRO_PIXEL_FORMAT_XRGB8888;
+#else
    enum retro_pixel_format fmt = RETRO_PIXEL_FORMAT_RGB565;
+#endif
    const char *system_dir      = NULL;
    const char *content_dir     = NULL;
    const char *save_dir        = NULL;
@@ -1862,6 +2122,7 @@ void retro_init(void)
    Config.save_fdd_path = 1;
    Config.clockmhz      = 10;
    Config.ram_size      = 2 * 1024 *1024;
+   Config.SampleRate    = 44100;
    Config.JOY_TYPE[0]   = 0;
    Config.JOY_TYPE[1]   = 0;
 
@@ -1890,6 +2151,7 @@ void retro_deinit(void)
    CDROM_Cleanup();
 #endif
    MIDI_Cleanup();
+   Rewind_Free();
    WinX68k_Cleanup();
    WinDraw_Cleanup();
 
@@ -1897,6 +2159,8 @@ void retro_deinit(void)
    libretro_supports_input_bitmasks    = 0;
    libretro_supports_midi_output       = 0;
    libretro_supports_option_categories = 0;
+   audio_buff_status_set               = false;
+   update_audio_latency                = false;
 }
 
 void retro_reset(void)
@@ -2169,8 +2433,28 @@ static void WinX68k_Exec(void)
 
    if (Config.FrameRate != 7)
       DispFrame = (DispFrame + 1) % Config.FrameRate;
+   else if (audio_buff_status_set)
+   {				/* Auto Frame Skip, paced by the frontend's audio buffer */
+      bool skip = false;
+
+      if (audio_buff_active)
+         skip = Config.FrameSkipThreshold
+            ? (audio_buff_occupancy < (unsigned)Config.FrameSkipThreshold)
+            : audio_buff_underrun;
+
+      if (skip && frameskip_counter < FRAMESKIP_MAX)
+      {
+         frameskip_counter++;
+         DispFrame = 1;
+      }
+      else
+      {
+         frameskip_counter = 0;
+         DispFrame         = 0;
+      }
+   }
    else
-   {				/* Auto Frame Skip */
+   {				/* Auto Frame Skip, timed */
       if (FrameSkipQueue)
       {
          if (FrameSkipCount > 15)
@@ -2285,7 +2569,6 @@ static void WinX68k_Exec(void)
 
       if (clk_count >= clk_next)
       {
-         MIDI_DelayOut((Config.MIDIAutoDelay)?(Config.BufferSize*5):Config.MIDIDelay);
          MFP_TimerA();
          if ((MFP[MFP_AER] & 0x40) && (vline == CRTC_IntLine))
             MFP_Int(1);
@@ -2301,9 +2584,7 @@ static void WinX68k_Exec(void)
             {
                /* LowReso 512dot
                 * draw twice per scanline (interlace) */
-               WinDraw_DrawLine();
-               VLINE++;
-               WinDraw_DrawLine();
+               WinDraw_DrawLinePair();
             }
             else /* High 512dot / Low 256dot */
                WinDraw_DrawLine();
@@ -2362,8 +2643,11 @@ static void WinX68k_Exec(void)
    if (!DispFrame)
       WinDraw_Draw();
 
+   MIDI_DelayOut();
+
    t_end = timeGetTime();
-   if ((int)(t_end - t_start) > ((CRTC_Regs[0x29] & 0x10) ? 14 : 16))
+   if (Config.FrameRate == 7 && !audio_buff_status_set
+         && (int)(t_end - t_start) > ((CRTC_Regs[0x29] & 0x10) ? 14 : 16))
    {
       FrameSkipQueue += ((t_end - t_start) / ((CRTC_Regs[0x29] & 0x10) ? 14 : 16)) + 1;
       if (FrameSkipQueue > 100)
@@ -2382,9 +2666,12 @@ void retro_run(void)
    {
       pre_main();
       firstcall     = 0;
+      serialize_size = 0;
       /* Initialization done */
       update_variables(0);
       soundbuf_size = SNDSZ;
+      BootCache_Start(retro_save_directory ? retro_save_directory : retro_system_conf,
+            opt_boot_cache);
       return;
    }
 
@@ -2401,6 +2688,7 @@ void retro_run(void)
          system_av_info.timing.fps            = FRAMERATE;
          environ_cb(RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO, &system_av_info);
          setup_frame_time_cb();
+         update_audio_latency                 = true;
          CHANGEAV_TIMING                      = 0;
          CHANGEAV                             = 0;
       }
@@ -2416,6 +2704,21 @@ void retro_run(void)
       soundbuf_size                           = SNDSZ;
    }
 
+   if (update_audio_latency)
+   {
+      /* six frames of headroom for Auto Frame Skip, rounded up to a
+       * multiple of 32 ms; 0 lets the frontend choose */
+      unsigned latency = 0;
+
+      if (audio_buff_status_set)
+      {
+         latency = (unsigned)(6.0 * 1000.0 / FRAMERATE + 0.5);
+         latency = (latency + 0x1f) & ~0x1f;
+      }
+      environ_cb(RETRO_ENVIRONMENT_SET_MINIMUM_AUDIO_LATENCY, &latency);
+      update_audio_latency = false;
+   }
+
    input_poll_cb();
    rumble_frames();
 
@@ -2431,7 +2734,23 @@ void retro_run(void)
           Joystick_Update(0, -1, 1);
       }
 
+      /* Joypad key for the in-core rewind.  Frames re-run for
+       * runahead or rollback are not shown and stay out of the history */
+      if (FrameIsShown())
+      {
+         if (!input_state_cb(0, RETRO_DEVICE_JOYPAD, 0, RETRO_DEVICE_ID_JOYPAD_L3)
+               || !Rewind_Step())
+            Rewind_Push(retro_serialize_size());
+      }
+
       WinX68k_Exec();
+      BootCache_Frame();
+
+      if (state_benchmark_pending)
+      {
+         PX68KSS_Benchmark(opt_state_benchmark);
+         state_benchmark_pending = false;
+      }
    }
 
    if (!Config.JoyOrMouse) {
@@ -2562,6 +2881,6 @@ void retro_run(void)
 
    audio_batch_cb((const int16_t*)soundbuf, soundbuf_size);
    /* TODO/FIXME - hardcoded pitch here */
-   video_cb(videoBuffer, retrow, retroh, /*retrow*/ 800 << 1);
+   video_cb(videoBuffer, retrow, retroh, /*retrow*/ 800 * sizeof(pixel_t));
 }
 
@@ -0,0 +1,344 @@
+/*
+ * BOOTCACHE.C - Instant boot from a stored state
+ *
+ * A set number of frames after a cold start the machine is saved to the
+ * given directory, under a hash of everything the boot depends on: the
+ * ROMs, the floppy images, the hard disk images' names and sizes and the
+ * machine options.  A later launch with the same hash loads that state
+ * instead of running the IPL memory check and booting the disks again.
+ *
+ * Of the hard disk images only the sectors the boot read or wrote count:
+ * they are listed in the file ahead of the state, with a hash of their
+ * contents as stored, and a launch reads them again to check the hash.
+ * Should the boot touch more sectors than the list holds, the images
+ * are hashed whole instead.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <file/file_path.h>
+#include <streams/file_stream.h>
+
+#include "common.h"
+#include "prop.h"
+#include "state.h"
+#include "winx68k.h"
+#include "x68kmemory.h"
+#include "bootcache.h"
+
+static char cache_path[1024];
+static int frames_left = 0;   /* until the state is stored; 0 once done or off */
+
+static uint64_t HashBytes(uint64_t h, const uint8_t *p, size_t len)
+{
+   for (; len >= 8; p += 8, len -= 8)
+   {
+      uint64_t w;
+      memcpy(&w, p, 8);
+      h  = (h ^ w) * 0x100000001b3ULL;
+      h ^= h >> 29;
+   }
+   while (len--)
+      h = (h ^ *p++) * 0x100000001b3ULL;
+
+   return h;
+}
+
+/* Sectors as drive << 24 | sector, SASI sectors being 21 bits */
+#define BOOT_SECTORS_MAX 16384
+#define SECTOR_SIZE      256
+
+static uint32_t boot_sectors[BOOT_SECTORS_MAX];
+static int boot_sector_count = 0;
+static bool boot_sectors_whole = false;   /* too many, hash whole images */
+
+/* Ahead of the state in a cache file */
+typedef struct
+{
+   char     magic[8];
+   uint32_t count;    /* of sectors listed after this */
+   uint32_t whole;
+   uint64_t hash;     /* of those sectors, or whole images */
+} BootCacheHeader;
+
+static const char boot_magic[8] = "PX68KBC";
+
+static uint64_t HashRange(uint64_t h, RFILE *fp, int64_t pos, int64_t len)
+{
+   static uint8_t buf[65536];
+   int64_t n;
+
+   if (filestream_seek(fp, pos, RETRO_VFS_SEEK_POSITION_START) < 0)
+      return HashBytes(h, (const uint8_t *)"?", 1);
+
+   for (; len > 0; len -= n)
+   {
+      n = filestream_read(fp, buf, len < (int64_t)sizeof(buf) ? len : (int64_t)sizeof(buf));
+      if (n <= 0)
+         break;
+      h = HashBytes(h, buf, (size_t)n);
+   }
+
+   return h;
+}
+
+/* Hashes the path and the size of an image and, if whole, its contents.
+ * An image that is set but cannot be read hashes apart from no image */
+static uint64_t HashFile(uint64_t h, const char *path, bool whole)
+{
+   RFILE *fp;
+   int64_t size;
+
+   if (!path[0])
+      return HashBytes(h, (const uint8_t *)"", 1);
+
+   fp = filestream_open(path, RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+   if (!fp)
+      return HashBytes(h, (const uint8_t *)"?", 1);
+
+   size = filestream_get_size(fp);
+   h    = HashBytes(h, (const uint8_t *)path, strlen(path) + 1);
+   h    = HashBytes(h, (const uint8_t *)&size, sizeof(size));
+   if (whole)
+      h = HashRange(h, fp, 0, size);
+   filestream_close(fp);
+
+   return h;
+}
+
+static int CompareSectors(const void *a, const void *b)
+{
+   uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+   return x < y ? -1 : x > y;
+}
+
+/* Sorts the list and drops repeats */
+static void SortSectors(void)
+{
+   int i, n = 0;
+
+   qsort(boot_sectors, boot_sector_count, sizeof(boot_sectors[0]), CompareSectors);
+   for (i = 0; i < boot_sector_count; i++)
+      if (!n || boot_sectors[i] != boot_sectors[n - 1])
+         boot_sectors[n++] = boot_sectors[i];
+   boot_sector_count = n;
+}
+
+/* Hashes the contents of the listed sectors, which are sorted */
+static uint64_t HashSectors(void)
+{
+   uint64_t h = 0xcbf29ce484222325ULL;
+   RFILE *fp  = NULL;
+   int drive  = -1;
+   int i;
+
+   if (boot_sectors_whole)
+   {
+      for (i = 0; i < 16; i++)
+         h = HashFile(h, Config.HDImage[i], true);
+      return h;
+   }
+
+   for (i = 0; i < boot_sector_count; i++)
+   {
+      int d = boot_sectors[i] >> 24;
+
+      if (d != drive)
+      {
+         if (fp)
+            filestream_close(fp);
+         drive = d;
+         fp    = d < 16 && Config.HDImage[d][0] ? filestream_open(Config.HDImage[d],
+               RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE) : NULL;
+      }
+      h = HashBytes(h, (const uint8_t *)&boot_sectors[i], sizeof(boot_sectors[i]));
+      if (fp)
+         h = HashRange(h, fp, (int64_t)(boot_sectors[i] & 0xffffff) * SECTOR_SIZE, SECTOR_SIZE);
+      else
+         h = HashBytes(h, (const uint8_t *)"?", 1);
+   }
+   if (fp)
+      filestream_close(fp);
+
+   return h;
+}
+
+/* Takes the list and checks the sectors against the hash stored with it */
+static bool CheckSectors(const uint8_t *data, int64_t len, int64_t *state_pos)
+{
+   BootCacheHeader hdr;
+
+   if (len < (int64_t)sizeof(hdr))
+      return false;
+   memcpy(&hdr, data, sizeof(hdr));
+   if (memcmp(hdr.magic, boot_magic, sizeof(boot_magic))
+         || hdr.count > BOOT_SECTORS_MAX
+         || len < (int64_t)(sizeof(hdr) + hdr.count * sizeof(boot_sectors[0])))
+      return false;
+
+   boot_sector_count  = hdr.count;
+   boot_sectors_whole = hdr.whole != 0;
+   memcpy(boot_sectors, data + sizeof(hdr), hdr.count * sizeof(boot_sectors[0]));
+   *state_pos = sizeof(hdr) + hdr.count * sizeof(boot_sectors[0]);
+
+   return HashSectors() == hdr.hash;
+}
+
+void BootCache_DiskAccess(int drive, uint32_t sector)
+{
+   if (!frames_left || boot_sectors_whole)
+      return;
+
+   if (boot_sector_count == BOOT_SECTORS_MAX)
+   {
+      SortSectors();
+      if (boot_sector_count == BOOT_SECTORS_MAX)
+      {
+         boot_sectors_whole = true;
+         return;
+      }
+   }
+   boot_sectors[boot_sector_count++] = (uint32_t)drive << 24 | (sector & 0xffffff);
+}
+
+bool BootCache_Start(const char *dir, int frames)
+{
+   uint64_t h = 0xcbf29ce484222325ULL;
+   int32_t opts[8];
+   char name[64];
+   void *buf   = NULL;
+   int64_t len = 0;
+   int i;
+
+   frames_left = 0;
+   if (frames <= 0 || !dir || !dir[0])
+      return false;
+
+   /* SRAM is left out: this build always starts it blank */
+   opts[0] = PX68K_VERSION_NUMERIC;
+   opts[1] = frames;
+   opts[2] = Config.clockmhz;
+   opts[3] = Config.ram_size;
+   opts[4] = Config.SampleRate;
+   opts[5] = Config.OPMRate;
+   opts[6] = Config.MIDI_SW;
+   opts[7] = Config.MIDI_Type;
+
+   h = HashBytes(h, (const uint8_t *)opts, sizeof(opts));
+   h = HashBytes(h, IPL, 0x40000);
+   h = HashBytes(h, FONT, 0xc0000);
+   h = HashBytes(h, SCSIIPL, sizeof(SCSIIPL));
+   for (i = 0; i < 2; i++)
+      h = HashFile(h, Config.FDDImage[i], true);
+   for (i = 0; i < 16; i++)
+      h = HashFile(h, Config.HDImage[i], false);
+
+   snprintf(name, sizeof(name), "px68k_boot_%08x%08x.state",
+         (unsigned)(h >> 32), (unsigned)h);
+   fill_pathname_join(cache_path, dir, name, sizeof(cache_path));
+
+   if (filestream_read_file(cache_path, &buf, &len) && len > 0)
+   {
+      StateMem st;
+      int64_t pos;
+      int ok;
+
+      if (!CheckSectors((const uint8_t *)buf, len, &pos))
+      {
+         free(buf);
+         log_cb(RETRO_LOG_INFO, "boot cache: disk changed since %s, booting\n", cache_path);
+         goto boot;
+      }
+
+      st.data           = (uint8_t *)buf + pos;
+      st.loc            = 0;
+      st.len            = (uint32_t)(len - pos);
+      st.malloced       = 0;
+      st.initial_malloc = 0;
+      st.fastsavestates = 0;
+      st.sizeonly       = 0;
+      st.fixedsize      = 0;
+      st.delta          = 0;
+      st.raw            = 0;
+      st.compress       = 0;
+
+      ok = PX68KSS_LoadSM(&st, 0, 0);
+      free(buf);
+
+      if (ok)
+      {
+         log_cb(RETRO_LOG_INFO, "boot cache: loaded %s\n", cache_path);
+         return true;
+      }
+
+      /* the state may have been taken in part; it is replaced once
+       * the machine has booted again */
+      log_cb(RETRO_LOG_WARN, "boot cache: cannot load %s, booting\n", cache_path);
+      WinX68k_Reset();
+   }
+   else
+      free(buf);
+
+boot:
+   boot_sector_count  = 0;
+   boot_sectors_whole = false;
+   frames_left        = frames;
+   return false;
+}
+
+void BootCache_Frame(void)
+{
+   BootCacheHeader hdr;
+   StateMem st;
+   size_t list;
+   uint8_t *data;
+
+   if (!frames_left || --frames_left)
+      return;
+
+   SortSectors();
+   memcpy(hdr.magic, boot_magic, sizeof(boot_magic));
+   hdr.count = boot_sectors_whole ? 0 : boot_sector_count;
+   hdr.whole = boot_sectors_whole;
+   hdr.hash  = HashSectors();
+   list      = hdr.count * sizeof(boot_sectors[0]);
+
+   st.data           = NULL;
+   st.loc            = 0;
+   st.len            = 0;
+   st.malloced       = 0;
+   st.initial_malloc = 0;
+   st.fastsavestates = 0;
+   st.sizeonly       = 0;
+   st.fixedsize      = 0;
+   st.delta          = 0;
+   st.raw            = 0;
+   st.compress       = 1;
+
+   data = NULL;
+   if (PX68KSS_SaveSM(&st, 0, 0, NULL, NULL, NULL)
+         && (data = (uint8_t *)malloc(sizeof(hdr) + list + st.len)))
+   {
+      memcpy(data, &hdr, sizeof(hdr));
+      memcpy(data + sizeof(hdr), boot_sectors, list);
+      memcpy(data + sizeof(hdr) + list, st.data, st.len);
+   }
+
+   if (data && filestream_write_file(cache_path, data, sizeof(hdr) + list + st.len))
+   {
+      if (boot_sectors_whole)
+         log_cb(RETRO_LOG_INFO, "boot cache: stored %s, hard disks whole\n", cache_path);
+      else
+         log_cb(RETRO_LOG_INFO, "boot cache: stored %s, %d hard disk sectors\n",
+               cache_path, boot_sector_count);
+   }
+   else
+      log_cb(RETRO_LOG_WARN, "boot cache: cannot store %s\n", cache_path);
+
+   free(data);
+   free(st.data);
+}
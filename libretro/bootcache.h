@@ -0,0 +1,19 @@
+#ifndef _BOOTCACHE_H
+#define _BOOTCACHE_H
+
+#include <stdint.h>
+#include <boolean.h>
+
+/* Called once the machine is set up for a cold start.  Loads the state
+ * stored for this set up, or else arranges for one to be stored after
+ * frames emulated frames; 0 turns the cache off.  True if a state was
+ * loaded. */
+bool BootCache_Start(const char *dir, int frames);
+
+/* Called after every emulated frame */
+void BootCache_Frame(void);
+
+/* Called for every sector of hard disk image drive read or written */
+void BootCache_DiskAccess(int drive, uint32_t sector);
+
+#endif /* _BOOTCACHE_H */
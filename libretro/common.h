@@ -11,6 +11,14 @@ extern retro_log_printf_t log_cb;
 #include "state.h"
 #include "state_inline.h"
 
+/* Host pixel of the video pipeline: RGB565 by default, XRGB8888 when
+ * built with XRGB8888=1. */
+#ifdef PX68K_XRGB8888
+typedef uint32_t pixel_t;
+#else
+typedef uint16_t pixel_t;
+#endif
+
 #undef FASTCALL
 #define FASTCALL
 
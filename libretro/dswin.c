@@ -31,12 +31,20 @@
 #include	"mercury.h"
 #include	"fmg_wrap.h"
 
+/* one second at the highest output rate */
 #define PCMBUF_SIZE 2*2*48000
+/* stereo samples the mixing bus holds */
+#define MIXBUF_LEN  (PCMBUF_SIZE/4)
 
 static uint8_t pcmbuffer[PCMBUF_SIZE];
 static uint8_t rsndbuf  [PCMBUF_SIZE];
 static int32_t snd_precounter = 0;
 
+/* Samples not yet written to pcmbuffer: every source adds into this
+ * linear 32-bit bus and sound_flush() saturates it once into the ring */
+static int32_t mixbuffer[MIXBUF_LEN*2];
+static int mixlen = 0;
+
 uint8_t *pbsp = pcmbuffer;
 uint8_t *pbrp = pcmbuffer, *pbwp = pcmbuffer;
 uint8_t *pbep = &pcmbuffer[PCMBUF_SIZE];
@@ -67,21 +75,64 @@ void DSound_Stop(void)
 	OPM_SetVolume(0);	
 }
 
-static void sound_send(int length)
+static void sound_flush(void)
 {
-   ADPCM_Update((int16_t *)pbwp, length, pbsp, pbep);
-   OPM_Update((int16_t *)pbwp, length, pbsp, pbep);
+   int32_t *src = mixbuffer;
+   int n = mixlen * 2;
+
+   /* the OPM may still have queued output for the bus */
+   OPM_Flush();
+
+   while (n > 0)
+   {
+      int16_t *dst = (int16_t *)pbwp;
+      int seg = (int16_t *)pbep - dst;
+      int i;
 
-   pbwp += length * sizeof(uint16_t) * 2;
-   if (pbwp >= pbep)
-      pbwp = pbsp + (pbwp - pbep);
+      if (seg > n)
+         seg = n;
+      for (i = 0; i < seg; i++)
+      {
+         int32_t s = src[i];
+         dst[i] = (s > 32767) ? 32767 : (s < -32768) ? -32768 : (int16_t)s;
+      }
+      src  += seg;
+      n    -= seg;
+      pbwp += seg * sizeof(int16_t);
+      if (pbwp >= pbep)
+         pbwp = pbsp;
+   }
+   mixlen = 0;
+}
+
+static void sound_send(int length)
+{
+   while (length > 0)
+   {
+      int n = (length < MIXBUF_LEN) ? length : MIXBUF_LEN;
+      int32_t *buf;
+
+      if (mixlen + n > MIXBUF_LEN)
+         sound_flush();
+      buf = &mixbuffer[mixlen * 2];
+
+      /* ADPCM stores, the other sources add */
+      ADPCM_Update(buf, n);
+#ifndef NO_MERCURY
+      Mcry_Update(buf, n);
+#endif
+      OPM_Update(buf, n);
+
+      mixlen += n;
+      length -= n;
+   }
 }
 
 void DSound_Send0(int32_t clock)
 {
 	int length = 0;
 
-	snd_precounter += (44100 * clock);
+	snd_precounter += (Config.SampleRate * clock);
 
 	while (snd_precounter >= 10000000L)
 	{
@@ -96,13 +147,16 @@ void DSound_Send0(int32_t clock)
 int audio_samples_avail(void)
 {
    if (pbrp <= pbwp)
-      return (pbwp - pbrp) / 4;
-   return (pbep - pbrp) / 4 + (pbwp - pbsp) / 4;
+      return (pbwp - pbrp) / 4 + mixlen;
+   return (pbep - pbrp) / 4 + (pbwp - pbsp) / 4 + mixlen;
 }
 
 void audio_samples_discard(int discard)
 {
-   int avail = audio_samples_avail();
+   int avail;
+
+   sound_flush();
+   avail = audio_samples_avail();
    if (discard > avail)
       discard = avail;
 
@@ -128,6 +182,7 @@ void raudio_callback(void *userdata, unsigned char *stream, int len)
    uint8_t *buf;
 
 cb_start:
+   sound_flush();
    if (pbrp <= pbwp)
    {
       /* pcmbuffer
@@ -146,6 +201,7 @@ cb_start:
       {
 	      int length = (len - datalen) / 4;
 	      sound_send(length);
+	      sound_flush();
       }
 
       /* change to TYPEC or TYPED */
@@ -181,6 +237,7 @@ cb_start:
 	 {
 		 int length = (lenb - (pbwp - pbsp)) / 4;
 		 sound_send(length);
+		 sound_flush();
 	 }
 
          memcpy(rsndbuf, pbrp, lena);
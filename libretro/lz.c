@@ -0,0 +1,211 @@
+/*
+ * LZ.C - Small LZ77 block codec for savestate data
+ *
+ * A block is a sequence of tokens.  The high nibble of a token is the
+ * number of literals that follow it and the low nibble the match length
+ * minus LZ_MINMATCH; 15 means that bytes of 255 and one final byte below
+ * 255 are added to it.  Each literal run is followed by a 16-bit little
+ * endian match offset and the match, except for the last one, which ends
+ * the block.  Matches may overlap the bytes they produce, so long runs of
+ * one value cost a few bytes.
+ */
+
+#include <string.h>
+
+#include <retro_inline.h>
+
+#include "lz.h"
+
+#define LZ_MINMATCH 4
+#define LZ_MAXDIST  65535
+#define LZ_HASHLOG  14
+
+static uint32_t lz_table[1 << LZ_HASHLOG];
+
+static INLINE uint32_t lz_read32(const uint8_t *p)
+{
+   uint32_t v;
+   memcpy(&v, p, 4);
+   return v;
+}
+
+static INLINE uint32_t lz_hash(uint32_t v)
+{
+   return (v * 2654435761U) >> (32 - LZ_HASHLOG);
+}
+
+static uint8_t *lz_length(uint8_t *op, uint8_t *oend, size_t n)
+{
+   while (n >= 255)
+   {
+      if (op >= oend)
+         return NULL;
+      *op++ = 255;
+      n    -= 255;
+   }
+   if (op >= oend)
+      return NULL;
+   *op++ = (uint8_t)n;
+   return op;
+}
+
+/* Literals from anchor to ip, then a match unless mlen is 0 */
+static uint8_t *lz_sequence(uint8_t *op, uint8_t *oend, const uint8_t *anchor,
+      const uint8_t *ip, size_t off, size_t mlen)
+{
+   size_t lit   = ip - anchor;
+   uint8_t *tok = op++;
+
+   if (op > oend)
+      return NULL;
+
+   *tok = (uint8_t)(((lit < 15) ? lit : 15) << 4);
+   if (lit >= 15 && !(op = lz_length(op, oend, lit - 15)))
+      return NULL;
+
+   if ((size_t)(oend - op) < lit)
+      return NULL;
+   memcpy(op, anchor, lit);
+   op += lit;
+
+   if (!mlen)
+      return op;
+
+   if (oend - op < 2)
+      return NULL;
+   *op++ = (uint8_t)off;
+   *op++ = (uint8_t)(off >> 8);
+
+   mlen -= LZ_MINMATCH;
+   *tok |= (uint8_t)((mlen < 15) ? mlen : 15);
+   if (mlen >= 15 && !(op = lz_length(op, oend, mlen - 15)))
+      return NULL;
+
+   return op;
+}
+
+size_t LZ_Compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap)
+{
+   const uint8_t *ip     = src;
+   const uint8_t *anchor = src;
+   const uint8_t *iend   = src + len;
+   uint8_t *op           = dst;
+   uint8_t *oend         = dst + cap;
+
+   memset(lz_table, 0, sizeof(lz_table));
+
+   while (len >= LZ_MINMATCH && ip <= iend - LZ_MINMATCH)
+   {
+      uint32_t seq     = lz_read32(ip);
+      uint32_t h       = lz_hash(seq);
+      const uint8_t *r = src + lz_table[h];
+      size_t mlen;
+
+      lz_table[h] = (uint32_t)(ip - src);
+
+      if (r >= ip || (size_t)(ip - r) > LZ_MAXDIST || lz_read32(r) != seq)
+      {
+         /* skip ahead faster through data that does not compress */
+         ip += 1 + ((ip - anchor) >> 6);
+         continue;
+      }
+
+      /* grow the match backwards over pending literals, then forwards */
+      while (ip > anchor && r > src && ip[-1] == r[-1])
+      {
+         ip--;
+         r--;
+      }
+      mlen = LZ_MINMATCH;
+      while (ip + mlen + 8 <= iend && lz_read32(ip + mlen) == lz_read32(r + mlen)
+            && lz_read32(ip + mlen + 4) == lz_read32(r + mlen + 4))
+         mlen += 8;
+      while (ip + mlen < iend && ip[mlen] == r[mlen])
+         mlen++;
+
+      if (!(op = lz_sequence(op, oend, anchor, ip, ip - r, mlen)))
+         return 0;
+      ip    += mlen;
+      anchor = ip;
+   }
+
+   if (!(op = lz_sequence(op, oend, anchor, iend, 0, 0)))
+      return 0;
+
+   return op - dst;
+}
+
+size_t LZ_Decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap)
+{
+   const uint8_t *ip   = src;
+   const uint8_t *iend = src + len;
+   uint8_t *op         = dst;
+   uint8_t *oend       = dst + cap;
+
+   while (ip < iend)
+   {
+      uint8_t tok = *ip++;
+      size_t lit  = tok >> 4;
+      size_t mlen = tok & 15;
+      size_t off;
+      const uint8_t *r;
+
+      if (lit == 15)
+      {
+         uint8_t b;
+         do
+         {
+            if (ip >= iend)
+               return 0;
+            b    = *ip++;
+            lit += b;
+         } while (b == 255);
+      }
+
+      if ((size_t)(iend - ip) < lit || (size_t)(oend - op) < lit)
+         return 0;
+      memcpy(op, ip, lit);
+      ip += lit;
+      op += lit;
+
+      /* the last run has no match */
+      if (ip == iend)
+         break;
+
+      if (iend - ip < 2)
+         return 0;
+      off = ip[0] | (ip[1] << 8);
+      ip += 2;
+
+      if (mlen == 15)
+      {
+         uint8_t b;
+         do
+         {
+            if (ip >= iend)
+               return 0;
+            b     = *ip++;
+            mlen += b;
+         } while (b == 255);
+      }
+      mlen += LZ_MINMATCH;
+
+      if (!off || (size_t)(op - dst) < off || (size_t)(oend - op) < mlen)
+         return 0;
+
+      /* an overlapping match repeats what it has just written, in
+       * chunks that double in size */
+      r = op - off;
+      while (mlen)
+      {
+         size_t n = op - r;
+         if (n > mlen)
+            n = mlen;
+         memcpy(op, r, n);
+         op   += n;
+         mlen -= n;
+      }
+   }
+
+   return op - dst;
+}
@@ -0,0 +1,23 @@
+#ifndef _LZ_H
+#define _LZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Largest output LZ_Compress() can produce for len bytes */
+#define LZ_BOUND(len) ((len) + (len) / 255 + 16)
+
+/* Both return the number of bytes written, or 0 when dst is too small
+ * or, for LZ_Decompress(), when src is not a valid block */
+size_t LZ_Compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap);
+size_t LZ_Decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LZ_H */
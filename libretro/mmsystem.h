@@ -9,8 +9,9 @@
 extern "C" {
 #endif
 
-void midi_out_short_msg(size_t dwMsg);
-void midi_out_long_msg(uint8_t *s, size_t len);
+/* delta: microseconds since the previous message */
+void midi_out_short_msg(size_t dwMsg, uint32_t delta);
+void midi_out_long_msg(uint8_t *s, size_t len, uint32_t delta);
 int midi_out_open(void **phmo);
 
 #ifdef __cplusplus
@@ -62,14 +62,16 @@ static void LoadDefaults(void)
 	Config.XVIMode = 0;
 	Config.ToneMap = 0;
 	Config.ToneMapFile[0] = 0;
-	Config.MIDIDelay = Config.BufferSize*5;
-	Config.MIDIAutoDelay = 1;
 	Config.VbtnSwap = 0;
 	Config.JoyOrMouse = 1;
 
 	Config.NoWaitMode = 0;
 	Config.AdjustFrameRates = 1;
 	Config.AudioDesyncHack = 0;
+	Config.FrameSkipThreshold = 0;
+	Config.ReducedRes = 0;
+	Config.AudioThread = 0;
+	Config.OPMRate = 0;
 
 	for (i = 0; i < 2; i++)
 		Config.FDDImage[i][0] = '\0';
@@ -20,8 +20,6 @@ typedef struct
 	int XVIMode;
 	int Sound_LPF;
 	int SoundROMEO;
-	int MIDIDelay;
-	int MIDIAutoDelay;
 	char FDDImage[2][MAX_PATH];
 	int VbtnSwap;
 	int JoyOrMouse;
@@ -29,6 +27,12 @@ typedef struct
 	uint8_t FrameRate;
 	int AdjustFrameRates;
 	int AudioDesyncHack;
+	int FrameSkipThreshold; /* Auto Frame Skip: audio buffer % to skip below, 0 = on underrun */
+	/* Reduced output resolution: bit 0 = half width, bit 1 = half height */
+	int ReducedRes;
+	int AudioThread; /* render OPM on a worker thread (AUDIO_THREAD=1 builds) */
+	int OPMRate; /* OPM chip rate: 0 = output rate, 1 = native (clock/64), 2 = half native */
+	int SampleRate; /* sound mixer output rate in Hz */
 	int MenuFontSize; /* font size of menu, 0 = normal, 1 = large */
 	int joy1_select_mapping; /* used for keyboard to joypad map for P1 Select */
 	int save_fdd_path;
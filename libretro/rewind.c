@@ -0,0 +1,230 @@
+/*
+ * REWIND.C - In-core rewind
+ *
+ * A state is captured every rewind_step frames.  The latest one is kept
+ * as it is, every older one only as the LZ compressed XOR against the
+ * state that followed it, which is zero wherever nothing changed.
+ * Stepping back XORs the newest entry into the latest state and loads
+ * the result.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "state.h"
+#include "lz.h"
+#include "rewind.h"
+
+#define REWIND_MAX_ENTRIES 16384
+
+typedef struct
+{
+   uint8_t *data;
+   uint32_t size;    /* compressed bytes */
+   uint32_t len;     /* length of the state it leads back to */
+   uint32_t span;    /* bytes covered by the XOR */
+} RewindEntry;
+
+static RewindEntry *entries = NULL;
+static uint32_t first       = 0;
+static uint32_t count       = 0;
+static size_t used          = 0;
+static size_t budget        = 0;
+
+static int rewind_step      = 1;
+static int frame            = 0;
+
+/* latest state, the state being captured or restored, and the
+ * compressor output; all sized for the largest state */
+static uint8_t *cur         = NULL;
+static uint8_t *work        = NULL;
+static uint8_t *pack        = NULL;
+static uint32_t cur_len     = 0;
+static size_t cap           = 0;
+
+static void Rewind_Clear(void)
+{
+   while (count)
+   {
+      free(entries[first].data);
+      first = (first + 1) % REWIND_MAX_ENTRIES;
+      count--;
+   }
+   first = 0;
+   used  = 0;
+}
+
+void Rewind_Free(void)
+{
+   if (entries)
+      Rewind_Clear();
+   free(entries);
+   free(cur);
+   free(work);
+   free(pack);
+   entries = NULL;
+   cur     = NULL;
+   work    = NULL;
+   pack    = NULL;
+   cur_len = 0;
+   cap     = 0;
+}
+
+void Rewind_Setup(size_t bytes, int step)
+{
+   if (bytes != budget)
+      Rewind_Free();
+   budget      = bytes;
+   rewind_step = (step > 0) ? step : 1;
+}
+
+static bool Rewind_Alloc(size_t size)
+{
+   Rewind_Free();
+
+   entries = (RewindEntry *)calloc(REWIND_MAX_ENTRIES, sizeof(RewindEntry));
+   cur     = (uint8_t *)calloc(1, size);
+   work    = (uint8_t *)malloc(size);
+   pack    = (uint8_t *)malloc(LZ_BOUND(size));
+   if (!entries || !cur || !work || !pack)
+   {
+      Rewind_Free();
+      return false;
+   }
+   cap = size;
+   return true;
+}
+
+static void Rewind_Xor(uint8_t *dst, const uint8_t *src, size_t len)
+{
+   size_t i;
+
+   for (i = 0; i + 8 <= len; i += 8)
+   {
+      uint64_t a, b;
+      memcpy(&a, dst + i, 8);
+      memcpy(&b, src + i, 8);
+      a ^= b;
+      memcpy(dst + i, &a, 8);
+   }
+   for (; i < len; i++)
+      dst[i] ^= src[i];
+}
+
+void Rewind_Push(size_t size)
+{
+   StateMem st;
+   RewindEntry *e;
+   uint32_t span;
+   size_t n;
+
+   if (!budget || !size || ++frame < rewind_step)
+      return;
+   frame = 0;
+
+   if (size != cap && !Rewind_Alloc(size))
+      return;
+
+   st.data           = work;
+   st.loc            = 0;
+   st.len            = 0;
+   st.malloced       = cap;
+   st.initial_malloc = 0;
+   st.fastsavestates = 1;
+   st.sizeonly       = 0;
+   st.fixedsize      = 1;
+   st.delta          = 0;
+   st.raw            = 1;
+   st.compress       = 0;
+
+   if (!PX68KSS_SaveSM(&st, 0, 0, NULL, NULL, NULL))
+      return;
+
+   if (!cur_len)
+   {
+      memcpy(cur, work, st.len);
+      cur_len = st.len;
+      return;
+   }
+
+   /* past its end a state reads as zero in both buffers */
+   span = (st.len > cur_len) ? st.len : cur_len;
+   memset(work + st.len, 0, span - st.len);
+   Rewind_Xor(work, cur, span);
+   Rewind_Xor(cur, work, span);
+
+   n = LZ_Compress(work, span, pack, LZ_BOUND(span));
+   if (n > budget)
+      n = 0;
+
+   while (count && (count == REWIND_MAX_ENTRIES || used + n > budget))
+   {
+      used -= entries[first].size;
+      free(entries[first].data);
+      first = (first + 1) % REWIND_MAX_ENTRIES;
+      count--;
+   }
+
+   e       = &entries[(first + count) % REWIND_MAX_ENTRIES];
+   e->data = n ? (uint8_t *)malloc(n) : NULL;
+   if (!e->data)
+   {
+      /* without this step the older ones lead nowhere */
+      Rewind_Clear();
+      cur_len = st.len;
+      return;
+   }
+   memcpy(e->data, pack, n);
+   e->size = n;
+   e->len  = cur_len;
+   e->span = span;
+   used   += n;
+   count++;
+   cur_len = st.len;
+}
+
+bool Rewind_Step(void)
+{
+   StateMem st;
+
+   if (!budget || !cur_len)
+      return false;
+
+   if (count)
+   {
+      RewindEntry *e = &entries[(first + count - 1) % REWIND_MAX_ENTRIES];
+
+      if (LZ_Decompress(e->data, e->size, work, cap) == e->span)
+      {
+         Rewind_Xor(cur, work, e->span);
+         cur_len = e->len;
+      }
+      else
+         Rewind_Clear();
+
+      if (count)
+      {
+         used -= e->size;
+         free(e->data);
+         count--;
+      }
+   }
+
+   /* the oldest state is loaded over and over */
+   st.data           = cur;
+   st.loc            = 0;
+   st.len            = cur_len;
+   st.malloced       = 0;
+   st.initial_malloc = 0;
+   st.fastsavestates = 1;
+   st.sizeonly       = 0;
+   st.fixedsize      = 0;
+   st.delta          = 0;
+   st.raw            = 0;
+   st.compress       = 0;
+
+   frame = 0;
+   return PX68KSS_LoadSM(&st, 0, 0) != 0;
+}
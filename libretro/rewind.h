@@ -0,0 +1,18 @@
+#ifndef _REWIND_H
+#define _REWIND_H
+
+#include <stddef.h>
+
+#include <boolean.h>
+
+/* budget in bytes of compressed history, 0 turns rewinding off */
+void Rewind_Setup(size_t budget, int step);
+void Rewind_Free(void);
+
+/* Called at the start of every emulated frame; size is the most a
+ * state can take */
+void Rewind_Push(size_t size);
+/* Loads the previous captured state; false if there is none */
+bool Rewind_Step(void);
+
+#endif /* _REWIND_H */
@@ -17,6 +17,11 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
 
 #include <boolean.h>
 #include <retro_inline.h>
@@ -25,6 +30,7 @@
 
 #include "common.h"
 #include "state.h"
+#include "lz.h"
 
 #define SSEEK_END	2
 #define SSEEK_CUR	1
@@ -35,6 +41,24 @@
 /* Forward declaration */
 int StateAction(StateMem *sm, int load, int data_only);
 
+#define PAGE_SHIFT PX68KSTATE_PAGE_SHIFT
+#define PAGE_SIZE  PX68KSTATE_PAGE_SIZE
+
+/* Paged memory that delta states are taken against */
+#define MAX_PAGED 4
+static PX68KPages *paged[MAX_PAGED];
+static int paged_count = 0;
+
+/* Delta states name the base they were taken against.  The previous
+ * base is kept as well, and a new one is only taken after
+ * REBASE_MIN_SAVES saves, so the latest saves always load. */
+#define REBASE_MIN_SAVES 60
+static uint32_t base_gen   = 0;
+static uint32_t prev_gen   = 0;
+static uint32_t base_saves = 0;
+
+static const uint8_t zero_page[PAGE_SIZE];
+
 static INLINE void PX68K_en32lsb(uint8_t *buf, uint32_t morp)
 {
    buf[0]=morp;
@@ -137,6 +161,16 @@ static int32_t smem_read(StateMem *st, void *buffer, uint32_t len)
 
 static int32_t smem_write(StateMem *st, void *buffer, uint32_t len)
 {
+   /* past the end of a fixed buffer only the layout goes on, so that
+    * the overflow shows in len */
+   if (st->sizeonly || (st->fixedsize && (len + st->loc) > st->malloced))
+   {
+      st->loc += len;
+      if (st->loc > st->len)
+         st->len = st->loc;
+      return(len);
+   }
+
    if ((len + st->loc) > st->malloced)
    {
       uint32_t newsize = (st->malloced >= 32768) ? st->malloced : (st->initial_malloc ? st->initial_malloc : 32768);
@@ -202,6 +236,81 @@ static int smem_read32le(StateMem *st, uint32_t *b)
    return(4);
 }
 
+static void smem_write_name(StateMem *st, const char *name)
+{
+   char nameo[1 + 256];
+   int slen      = strlcpy(nameo + 1, name, 255);
+   nameo[256]    = 0;
+   nameo[0]      = slen;
+
+   smem_write(st, nameo, 1 + nameo[0]);
+}
+
+static INLINE bool PageSaved(PX68KPages *p, uint32_t i, uint32_t keep, bool delta)
+{
+   if (delta)
+      return p->dirty[i];
+   return i < keep || memcmp(p->mem + (i << PAGE_SHIFT), zero_page, PAGE_SIZE);
+}
+
+/*
+ * Paged memory is saved as its base generation (0 in a full state), the
+ * number of runs and of pages, and then each run of consecutive pages
+ * as its first page, its length and the data.
+ */
+static void WritePages(StateMem *st, SFORMAT *sf)
+{
+   PX68KPages *p  = (PX68KPages *)sf->v;
+   uint32_t pages = p->size >> PAGE_SHIFT;
+   uint32_t keep  = (p->keep + PAGE_SIZE - 1) >> PAGE_SHIFT;
+   bool delta     = st->delta && p->base && base_gen;
+   uint32_t size_pos, start, end, runs = 0, count = 0, i, j;
+
+   if (!st->fastsavestates && !st->raw)
+      smem_write_name(st, sf->name);
+
+   size_pos = st->loc;
+   smem_write32le(st, 0);
+   start = st->loc;
+
+   /* the most a state can take: every other page in its own run */
+   if (st->sizeonly)
+   {
+      st->loc += 12 + 8 * ((pages + 1) / 2) + p->size;
+      if (st->loc > st->len)
+         st->len = st->loc;
+      return;
+   }
+
+   smem_write32le(st, delta ? base_gen : 0);
+   smem_write32le(st, 0);
+   smem_write32le(st, 0);
+
+   for (i = 0; i < pages; i = j + 1)
+   {
+      if (!PageSaved(p, i, keep, delta))
+      {
+         j = i;
+         continue;
+      }
+      for (j = i + 1; j < pages && PageSaved(p, j, keep, delta); j++) { }
+
+      smem_write32le(st, i);
+      smem_write32le(st, j - i);
+      smem_write(st, p->mem + (i << PAGE_SHIFT), (j - i) << PAGE_SHIFT);
+      runs++;
+      count += j - i;
+   }
+
+   end = st->loc;
+   smem_seek(st, size_pos, SSEEK_SET);
+   smem_write32le(st, end - start);
+   smem_seek(st, start + 4, SSEEK_SET);
+   smem_write32le(st, runs);
+   smem_write32le(st, count);
+   smem_seek(st, end, SSEEK_SET);
+}
+
 static bool SubWrite(StateMem *st, SFORMAT *sf)
 {
    /* Size can sometimes be zero, so also check for the text name.
@@ -226,21 +335,30 @@ static bool SubWrite(StateMem *st, SFORMAT *sf)
          continue;
       }
 
+      if (sf->flags & PX68KSTATE_PAGED)
+      {
+         WritePages(st, sf);
+         sf++;
+         continue;
+      }
+
       bytesize = sf->size;
 
       /* exclude text labels from fast savestates */
       if (!st->fastsavestates)
-      {
-         char nameo[1 + 256];
-         int slen      = strlcpy(nameo + 1, sf->name, 255);
-         nameo[256]    = 0;
-         nameo[0]      = slen;
-
-         smem_write(st, nameo, 1 + nameo[0]);
-      }
+         smem_write_name(st, sf->name);
 
       smem_write32le(st, bytesize);
 
+      if (st->sizeonly)
+      {
+         st->loc += bytesize;
+         if (st->loc > st->len)
+            st->len = st->loc;
+         sf++;
+         continue;
+      }
+
 #ifdef MSB_FIRST
       /* Flip the byte order... */
       if(sf->flags & PX68KSTATE_BOOL) { }
@@ -317,7 +435,8 @@ static int WriteStateChunk(StateMem *st, const char *sname, SFORMAT *sf)
    smem_write32le(st, end_pos - data_start_pos);
    smem_seek(st, end_pos, SSEEK_SET);
 
-   return(end_pos - data_start_pos);
+   /* a section can be empty, e.g. when a ring buffer holds nothing */
+   return(1);
 }
 
 static SFORMAT *FindSF(const char *name, SFORMAT *sf, bool FastSaveStates)
@@ -357,9 +476,319 @@ static SFORMAT *FindSF(const char *name, SFORMAT *sf, bool FastSaveStates)
    return NULL;
 }
 
+/* Labelled loads look names up in hash tables built once per list,
+ * rather than scanning the lists for every entry they read */
+#define MAX_FIELDS   1024
+#define MAX_SECTIONS 256
+
+static SFORMAT *field_list[MAX_FIELDS];
+static uint16_t field_hash[MAX_FIELDS * 2];   /* index + 1, 0 if free */
+static uint32_t field_count;
+
+/* The index of a list is kept for the next load.  Most lists are arrays
+ * on the stack of a StateAction function and come back at the same
+ * address with the same number of fields; as another function's list
+ * may take the same stack slot, the entries and their names are checked
+ * before the index is used again */
+#define FIELD_CACHE  32
+#define CACHE_FIELDS 128   /* longer lists are indexed on every load */
+
+struct FieldIndex
+{
+   SFORMAT *sf;        /* the list, NULL if the slot is free */
+   uint32_t count;
+   uint32_t mask;
+   SFORMAT *list[CACHE_FIELDS];
+   const char *names[CACHE_FIELDS];
+   uint16_t hash[CACHE_FIELDS * 2];
+};
+
+static struct FieldIndex field_cache[FIELD_CACHE];
+static uint32_t field_cache_next;   /* the slot to be taken next */
+
+/* The index ReadStateChunk works with */
+static SFORMAT **index_list;
+static uint16_t *index_hash;
+static uint32_t index_count, index_mask;
+
+struct SectionEntry
+{
+   const char *name;   /* in the state data, 32 bytes, not terminated */
+   uint32_t pos;       /* of the section data */
+   uint32_t size;
+};
+
+static struct SectionEntry section_list[MAX_SECTIONS];
+static uint16_t section_hash[MAX_SECTIONS * 2];
+static int section_count = -1;  /* -1 until the sections of the state are listed */
+static const uint8_t *section_data;
+static uint32_t section_start, section_len;
+
+static uint32_t NameHash(const char *name, uint32_t len)
+{
+   uint32_t h = 2166136261u;
+
+   while (len-- && *name)
+      h = (h ^ (uint8_t)*name++) * 16777619u;
+
+   return h;
+}
+
+/* Entries in the order SubWrite stores them, links followed */
+static bool ListFields(SFORMAT *sf)
+{
+   while(sf->size || sf->name)
+   {
+      if(!sf->size || !sf->v)
+      {
+         sf++;
+         continue;
+      }
+
+      if(sf->size == (uint32_t)~0)
+      {
+         if(!ListFields((SFORMAT *)sf->v))
+            return false;
+      }
+      else if(field_count == MAX_FIELDS || !sf->name)
+         return false;
+      else
+         field_list[field_count++] = sf;
+
+      sf++;
+   }
+
+   return true;
+}
+
+static uint32_t HashFields(SFORMAT **list, uint32_t count, uint16_t *hash)
+{
+   uint32_t mask, i;
+
+   for(mask = 15; mask + 1 < count * 2; mask = mask * 2 + 1);
+   memset(hash, 0, (mask + 1) * sizeof(hash[0]));
+
+   for(i = 0; i < count; i++)
+   {
+      uint32_t h = NameHash(list[i]->name, 256) & mask;
+
+      /* as with FindSF, the first of two equal names wins */
+      while(hash[h] && strcmp(list[hash[h] - 1]->name, list[i]->name))
+         h = (h + 1) & mask;
+      if(!hash[h])
+         hash[h] = i + 1;
+   }
+
+   return mask;
+}
+
+static bool SameFields(const struct FieldIndex *fi)
+{
+   uint32_t i;
+
+   for(i = 0; i < fi->count; i++)
+      if(fi->list[i] != field_list[i] || fi->names[i] != field_list[i]->name)
+         return false;
+
+   return true;
+}
+
+static bool IndexFields(SFORMAT *sf, bool FastSaveStates)
+{
+   struct FieldIndex *fi = NULL;
+   uint32_t i;
+
+   field_count = 0;
+   if(!ListFields(sf))
+      return false;
+
+   if(field_count > CACHE_FIELDS)
+   {
+      index_list  = field_list;
+      index_count = field_count;
+      /* fast states are read back in order and need no names */
+      if(!FastSaveStates)
+      {
+         index_hash = field_hash;
+         index_mask = HashFields(field_list, field_count, field_hash);
+      }
+      return true;
+   }
+
+   for(i = 0; i < FIELD_CACHE; i++)
+   {
+      if(field_cache[i].sf == sf && field_cache[i].count == field_count
+            && SameFields(&field_cache[i]))
+      {
+         fi = &field_cache[i];
+         break;
+      }
+   }
+
+   if(!fi)
+   {
+      fi = &field_cache[field_cache_next];
+      field_cache_next = (field_cache_next + 1) % FIELD_CACHE;
+
+      fi->sf    = sf;
+      fi->count = field_count;
+      for(i = 0; i < field_count; i++)
+      {
+         fi->list[i]  = field_list[i];
+         fi->names[i] = field_list[i]->name;
+      }
+      fi->mask = HashFields(fi->list, fi->count, fi->hash);
+   }
+
+   index_list  = fi->list;
+   index_hash  = fi->hash;
+   index_count = fi->count;
+   index_mask  = fi->mask;
+
+   return true;
+}
+
+static SFORMAT *LookupField(const char *name)
+{
+   uint32_t h = NameHash(name, 256) & index_mask;
+
+   while(index_hash[h])
+   {
+      SFORMAT *sf = index_list[index_hash[h] - 1];
+
+      if(!strcmp(sf->name, name))
+         return sf;
+      h = (h + 1) & index_mask;
+   }
+
+   return NULL;
+}
+
+/* Lists the sections from st->loc on; section_count stays -1 if
+ * there are too many, and the sections are then searched one by one */
+static void IndexSections(StateMem *st)
+{
+   uint32_t loc  = st->loc;
+   uint32_t mask = MAX_SECTIONS * 2 - 1;
+
+   section_data  = st->data;
+   section_start = st->loc;
+   section_len   = st->len;
+   section_count = 0;
+   memset(section_hash, 0, sizeof(section_hash));
+
+   while(st->len - loc >= 32 + 4)
+   {
+      const char *name = (const char *)st->data + loc;
+      uint32_t size    = PX68K_de32lsb(st->data + loc + 32);
+      uint32_t h       = NameHash(name, 32) & mask;
+
+      /* the zeros after a state that is shorter than its buffer */
+      if(!name[0] || size > st->len - loc - 32 - 4)
+         break;
+      if(section_count == MAX_SECTIONS)
+      {
+         section_count = -1;
+         return;
+      }
+
+      while(section_hash[h] && strncmp(section_list[section_hash[h] - 1].name, name, 32))
+         h = (h + 1) & mask;
+      if(!section_hash[h])
+         section_hash[h] = section_count + 1;
+
+      section_list[section_count].name = name;
+      section_list[section_count].pos  = loc + 32 + 4;
+      section_list[section_count].size = size;
+      section_count++;
+
+      loc += 32 + 4 + size;
+   }
+}
+
+static struct SectionEntry *LookupSection(const char *name)
+{
+   uint32_t mask = MAX_SECTIONS * 2 - 1;
+   uint32_t h    = NameHash(name, 32) & mask;
+
+   while(section_hash[h])
+   {
+      struct SectionEntry *s = &section_list[section_hash[h] - 1];
+
+      if(!strncmp(s->name, name, 32))
+         return s;
+      h = (h + 1) & mask;
+   }
+
+   return NULL;
+}
+
+static int ReadPages(StateMem *st, PX68KPages *p, uint32_t size)
+{
+   uint32_t pages = p->size >> PAGE_SHIFT;
+   uint32_t end   = st->loc + size;
+   uint32_t gen, runs, count, i;
+
+   /* a plain array, as saved before the memory was paged */
+   if (size == p->size)
+   {
+      if (smem_read(st, p->mem, size) != size)
+         return 0;
+      memset(p->dirty, 1, pages);
+      return 1;
+   }
+
+   if (!smem_read32le(st, &gen) || !smem_read32le(st, &runs) || !smem_read32le(st, &count))
+      return 0;
+
+   if (!gen)
+   {
+      memset(p->mem, 0, p->size);
+      memset(p->dirty, 1, pages);
+   }
+   else if (p->base && gen == base_gen)
+   {
+      /* back to the base, then the pages of the delta */
+      for (i = 0; i < pages; i++)
+         if (p->dirty[i])
+            memcpy(p->mem + (i << PAGE_SHIFT), p->base + (i << PAGE_SHIFT), PAGE_SIZE);
+      memset(p->dirty, 0, pages);
+   }
+   else if (p->base && gen == prev_gen)
+   {
+      for (i = 0; i < pages; i++)
+      {
+         if (p->prev_dirty[i])
+            memcpy(p->mem + (i << PAGE_SHIFT), p->prev + (i << PAGE_SHIFT), PAGE_SIZE);
+         else if (p->dirty[i])
+            memcpy(p->mem + (i << PAGE_SHIFT), p->base + (i << PAGE_SHIFT), PAGE_SIZE);
+      }
+      memcpy(p->dirty, p->prev_dirty, pages);
+   }
+   else
+      return 0;
+
+   while (runs--)
+   {
+      uint32_t first, len;
+
+      if (!smem_read32le(st, &first) || !smem_read32le(st, &len))
+         return 0;
+      if (first > pages || len > pages - first)
+         return 0;
+      if (smem_read(st, p->mem + (first << PAGE_SHIFT), len << PAGE_SHIFT) != (len << PAGE_SHIFT))
+         return 0;
+      memset(p->dirty + first, 1, len);
+   }
+
+   return smem_seek(st, end, SSEEK_SET) == 0;
+}
+
 static int ReadStateChunk(StateMem *st, SFORMAT *sf, int size)
 {
    int temp = st->loc;
+   bool indexed  = IndexFields(sf, st->fastsavestates);
+   uint32_t next = 0;
 
    uint32_t recorded_size;  /* In bytes */
    uint8_t toa[1 + 256];    /* Don't change to char unless 
@@ -387,15 +816,27 @@ static int ReadStateChunk(StateMem *st, SFORMAT *sf, int size)
 
       smem_read32le(st, &recorded_size);
 
-      tmp = FindSF((char*)toa + 1, sf, st->fastsavestates);
+      if (!indexed)
+      {
+         tmp = FindSF((char*)toa + 1, sf, st->fastsavestates);
 
-      /* Fix for unnecessary name checks, when we find 
-       * it in the first slot, don't recheck that slot again.
-       * Also necessary for fast savestates to work. */
-      if (tmp == sf)
-         sf++;
+         /* Fix for unnecessary name checks, when we find 
+          * it in the first slot, don't recheck that slot again.
+          * Also necessary for fast savestates to work. */
+         if (tmp == sf)
+            sf++;
+      }
+      else if (st->fastsavestates)
+         tmp = (next < index_count) ? index_list[next++] : NULL;
+      else
+         tmp = LookupField((char*)toa + 1);
 
-      if(tmp)
+      if(tmp && (tmp->flags & PX68KSTATE_PAGED))
+      {
+         if(!ReadPages(st, (PX68KPages *)tmp->v, recorded_size))
+            return(0);
+      }
+      else if(tmp)
       {
          uint32_t expected_size = tmp->size;	/* In bytes */
 
@@ -439,10 +880,74 @@ static int ReadStateChunk(StateMem *st, SFORMAT *sf, int size)
    return 1;
 }
 
+/* Every variable is copied as it is, in the order of the list */
+static int RawChunk(StateMem *st, int load, SFORMAT *sf)
+{
+   while(sf->size || sf->name)
+   {
+      uint32_t size = sf->size;
+
+      if(!sf->size || !sf->v)
+      {
+         sf++;
+         continue;
+      }
+
+      if(sf->size == (uint32_t)~0)
+      {
+         if(!RawChunk(st, load, (SFORMAT *)sf->v))
+            return(0);
+      }
+      else if(sf->flags & PX68KSTATE_PAGED)
+      {
+         if(!load)
+            WritePages(st, sf);
+         else if(!smem_read32le(st, &size) || !ReadPages(st, (PX68KPages *)sf->v, size))
+            return(0);
+      }
+      else
+      {
+         if(sf->flags & PX68KSTATE_BOOL)
+            size *= sizeof(bool);
+
+         if(!load)
+            smem_write(st, sf->v, size);
+         else if(smem_read(st, sf->v, size) != size)
+            return(0);
+      }
+
+      sf++;
+   }
+
+   return(1);
+}
+
 static int PX68KSS_StateAction_internal(StateMem *st, int load, int data_only,
-      struct SSDescriptor *section)
+      struct SSDescriptor *section, bool optional)
 {
-   if(load)
+   if(st->raw)
+      return RawChunk(st, load, section->sf);
+
+   if(load && section_count >= 0 &&
+         (section_data != st->data || section_start != st->loc || section_len != st->len))
+      IndexSections(st);
+
+   if(load && section_count >= 0)
+   {
+      struct SectionEntry *s = LookupSection(section->name);
+      uint32_t start         = st->loc;
+      int ret;
+
+      if(!s)
+         return(optional ? -1 : 0);
+
+      smem_seek(st, s->pos, SSEEK_SET);
+      ret = ReadStateChunk(st, section->sf, s->size);
+      smem_seek(st, start, SSEEK_SET);
+
+      return(ret);
+   }
+   else if(load)
    {
       char sname[32];
 
@@ -485,7 +990,7 @@ static int PX68KSS_StateAction_internal(StateMem *st, int load, int data_only,
 
       if(!found) // Not found.  We are sad!
       {
-         return(0);
+         return(optional ? -1 : 0);
       }
    }
    else
@@ -497,15 +1002,286 @@ static int PX68KSS_StateAction_internal(StateMem *st, int load, int data_only,
    return(1);
 }
 
+/* Section totals, gathered while PX68KSS_Benchmark() runs */
+#define MAX_BENCH 128
+
+typedef struct
+{
+   char name[32];
+   uint32_t bytes;      /* in the last save */
+   uint64_t save_ns;
+   uint64_t load_ns;
+} BenchEntry;
+
+static BenchEntry *bench = NULL;
+static int bench_count   = 0;
+static int bench_next    = 0;
+
+/* In nanoseconds, from a monotonic clock fine enough for one section */
+static uint64_t BenchTime(void)
+{
+#ifdef _WIN32
+   static LARGE_INTEGER freq;
+   LARGE_INTEGER now;
+
+   if (!freq.QuadPart)
+      QueryPerformanceFrequency(&freq);
+   QueryPerformanceCounter(&now);
+   return (uint64_t)(now.QuadPart / freq.QuadPart) * 1000000000
+      + (uint64_t)(now.QuadPart % freq.QuadPart) * 1000000000 / freq.QuadPart;
+#else
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+/* Sections come in the same order every time, so the one after the
+ * last is tried first */
+static BenchEntry *BenchFind(const char *name)
+{
+   int i;
+
+   if (bench_next < bench_count && !strncmp(bench[bench_next].name, name, 32))
+      return &bench[bench_next++];
+
+   for (i = 0; i < bench_count; i++)
+      if (!strncmp(bench[i].name, name, 32))
+         break;
+
+   if (i == bench_count)
+   {
+      if (bench_count == MAX_BENCH)
+         return NULL;
+      memset(&bench[i], 0, sizeof(bench[i]));
+      strlcpy(bench[i].name, name, sizeof(bench[i].name));
+      bench_count++;
+   }
+
+   bench_next = i + 1;
+   return &bench[i];
+}
+
 int PX68KSS_StateAction(void *st_p, int load, int data_only, SFORMAT *sf, const char *name, bool optional)
 {
    struct SSDescriptor love;
    StateMem *st   = (StateMem*)st_p;
+   uint32_t loc;
+   uint64_t t;
+   BenchEntry *e;
+   int ret;
 
    love.sf        = sf;
    love.name      = name;
 
-   return PX68KSS_StateAction_internal(st, load, 0, &love);
+   if (!bench)
+      return PX68KSS_StateAction_internal(st, load, 0, &love, optional);
+
+   loc = st->loc;
+   t   = BenchTime();
+   ret = PX68KSS_StateAction_internal(st, load, 0, &love, optional);
+   t   = BenchTime() - t;
+
+   if ((e = BenchFind(name)))
+   {
+      if (load)
+         e->load_ns += t;
+      else
+      {
+         e->save_ns += t;
+         e->bytes    = st->loc - loc;
+      }
+   }
+
+   return ret;
+}
+
+void PX68KSS_AddPages(PX68KPages *p)
+{
+   int i;
+
+   for (i = 0; i < paged_count; i++)
+      if (paged[i] == p)
+         return;
+   if (paged_count < MAX_PAGED)
+      paged[paged_count++] = p;
+}
+
+void PX68KSS_FreePages(void)
+{
+   int i;
+
+   for (i = 0; i < paged_count; i++)
+   {
+      free(paged[i]->base);
+      free(paged[i]->prev);
+      free(paged[i]->prev_dirty);
+      paged[i]->base       = NULL;
+      paged[i]->prev       = NULL;
+      paged[i]->prev_dirty = NULL;
+   }
+   paged_count = 0;
+   base_gen    = 0;
+   prev_gen    = 0;
+}
+
+static bool AllocPages(PX68KPages *p)
+{
+   p->base       = (uint8_t *)malloc(p->size);
+   p->prev       = (uint8_t *)malloc(p->size);
+   p->prev_dirty = (uint8_t *)malloc(p->size >> PAGE_SHIFT);
+   if (p->base && p->prev && p->prev_dirty)
+   {
+      memset(p->dirty, 1, p->size >> PAGE_SHIFT);
+      return true;
+   }
+
+   free(p->base);
+   free(p->prev);
+   free(p->prev_dirty);
+   p->base       = NULL;
+   p->prev       = NULL;
+   p->prev_dirty = NULL;
+   return false;
+}
+
+/* Takes a new base once enough has changed since the current one */
+static void UpdateBase(void)
+{
+   uint32_t dirty = 0, total = 0, pages, i;
+   int n;
+
+   for (n = 0; n < paged_count; n++)
+   {
+      PX68KPages *p = paged[n];
+
+      if (!p->base)
+      {
+         if (!AllocPages(p))
+            continue;
+         /* older deltas do not cover this memory */
+         base_gen = prev_gen = 0;
+      }
+
+      pages  = p->size >> PAGE_SHIFT;
+      total += pages;
+      for (i = 0; i < pages; i++)
+         dirty += p->dirty[i];
+   }
+
+   if (base_gen && (base_saves < REBASE_MIN_SAVES || dirty * 4 <= total))
+   {
+      base_saves++;
+      return;
+   }
+
+   for (n = 0; n < paged_count; n++)
+   {
+      PX68KPages *p = paged[n];
+
+      if (!p->base)
+         continue;
+
+      pages = p->size >> PAGE_SHIFT;
+      for (i = 0; i < pages; i++)
+      {
+         if (p->dirty[i])
+         {
+            memcpy(p->prev + (i << PAGE_SHIFT), p->base + (i << PAGE_SHIFT), PAGE_SIZE);
+            memcpy(p->base + (i << PAGE_SHIFT), p->mem + (i << PAGE_SHIFT), PAGE_SIZE);
+         }
+      }
+      memcpy(p->prev_dirty, p->dirty, pages);
+      memset(p->dirty, 0, pages);
+   }
+
+   prev_gen = base_gen;
+   if (++base_gen == 0)
+      base_gen = 1;
+   base_saves = 0;
+}
+
+/* Container of a packed state: "PX68KSVLZ" at 0, then at 16 the
+ * version, at 20 the unpacked length and at 24 the packed length */
+static const char *lz_magic = "PX68KSVLZ";
+
+static int SaveCompressed(StateMem *st)
+{
+   StateMem raw = *st;
+   uint8_t header[32];
+   uint8_t *pack;
+   size_t packed;
+   int ret;
+
+   raw.data      = NULL;
+   raw.loc       = 0;
+   raw.len       = 0;
+   raw.malloced  = 0;
+   raw.fixedsize = 0;
+   raw.compress  = 0;
+
+   if (!PX68KSS_SaveSM(&raw, 0, 0, NULL, NULL, NULL))
+   {
+      free(raw.data);
+      return(0);
+   }
+
+   /* the most the codec can make of it */
+   if (st->sizeonly)
+   {
+      st->loc += 32 + LZ_BOUND(raw.len);
+      if (st->loc > st->len)
+         st->len = st->loc;
+      return(1);
+   }
+
+   pack   = (uint8_t *)malloc(LZ_BOUND(raw.len));
+   packed = pack ? LZ_Compress(raw.data, raw.len, pack, LZ_BOUND(raw.len)) : 0;
+   free(raw.data);
+
+   if (!packed)
+   {
+      free(pack);
+      return(0);
+   }
+
+   memset(header, 0, sizeof(header));
+   memcpy(header, lz_magic, 9);
+   PX68K_en32lsb(header + 16, PX68K_VERSION_NUMERIC);
+   PX68K_en32lsb(header + 20, raw.len);
+   PX68K_en32lsb(header + 24, (uint32_t)packed);
+
+   smem_write(st, header, 32);
+   smem_write(st, pack, (uint32_t)packed);
+   free(pack);
+
+   ret = !(st->fixedsize && st->len > st->malloced);
+
+   return(ret);
+}
+
+static int LoadCompressed(StateMem *st, const uint8_t *header)
+{
+   StateMem raw    = *st;
+   uint32_t len    = PX68K_de32lsb(header + 20);
+   uint32_t packed = PX68K_de32lsb(header + 24);
+   int ret         = 0;
+
+   if (packed > st->len - st->loc)
+      return(0);
+
+   raw.data = (uint8_t *)malloc(len ? len : 1);
+   raw.loc  = 0;
+   raw.len  = len;
+
+   if (raw.data && LZ_Decompress(st->data + st->loc, packed, raw.data, len) == len)
+      ret = PX68KSS_LoadSM(&raw, 0, 0);
+
+   free(raw.data);
+   st->loc += packed;
+
+   return(ret);
 }
 
 int PX68KSS_SaveSM(void *st_p, int a, int b, const void*c, const void*d, const void*e)
@@ -515,9 +1291,23 @@ int PX68KSS_SaveSM(void *st_p, int a, int b, const void*c, const void*d, const v
    StateMem *st = (StateMem*)st_p;
    static const char *header_magic = "PX68KSVST";
 
+   if (st->compress)
+      return SaveCompressed(st);
+
    memset(header, 0, sizeof(header));
    memcpy(header, header_magic, 9);
 
+   if (st->delta && !st->sizeonly)
+   {
+      UpdateBase();
+      PX68K_en32lsb(header + 24, base_gen);
+   }
+   else
+      st->delta = 0;
+
+   if (st->raw)
+      PX68K_en32lsb(header + 28, 1);
+
    PX68K_en32lsb(header + 16, PX68K_VERSION_NUMERIC);
    smem_write(st, header, 32);
 
@@ -528,21 +1318,123 @@ int PX68KSS_SaveSM(void *st_p, int a, int b, const void*c, const void*d, const v
    smem_seek(st, 16 + 4, SSEEK_SET);
    smem_write32le(st, sizy);
 
+   if (st->fixedsize && st->len > st->malloced)
+      return(0);
+
    return(1);
 }
 
 int PX68KSS_LoadSM(void *st_p, int a, int b)
 {
    uint8_t header[32];
-   uint32_t stateversion;
+   uint32_t stateversion, gen;
    StateMem *st = (StateMem*)st_p;
 
-   smem_read(st, header, 32);
+   if (smem_read(st, header, 32) != 32)
+      return(0);
+
+   if (!memcmp(header, lz_magic, 9))
+      return LoadCompressed(st, header);
 
    if(memcmp(header, "PX68KSVESTATE", 13) && memcmp(header, "PX68KSVST", 9))
       return(0);
 
    stateversion = PX68K_de32lsb(header + 16);
 
+   /* a delta state is of no use once its base is gone */
+   gen = 0;
+   st->raw = 0;
+   if (!memcmp(header, "PX68KSVST", 9))
+   {
+      gen     = PX68K_de32lsb(header + 24);
+      st->raw = PX68K_de32lsb(header + 28) & 1;
+   }
+   if (gen && gen != base_gen && gen != prev_gen)
+      return(0);
+
+   /* the sections are listed when the first one is looked up */
+   section_count = 0;
+   section_data  = NULL;
+
    return(StateAction(st, stateversion, 0));
 }
+
+/* Saves and loads the running machine runs times in every layout and
+ * logs the average time and the size of the state and of each section.
+ * Every load puts back the state that was saved last, so the machine
+ * goes on as it was. */
+void PX68KSS_Benchmark(int runs)
+{
+   static const char *modes[3] = { "labelled", "fast", "raw" };
+   BenchEntry entries[MAX_BENCH];
+   StateMem st;
+   int mode, i;
+
+   if (runs <= 0)
+      return;
+
+   st.data           = NULL;
+   st.malloced       = 0;
+   st.initial_malloc = 0;
+   st.sizeonly       = 0;
+   st.fixedsize      = 0;
+   st.delta          = 0;
+   st.compress       = 0;
+
+   for (mode = 0; mode < 3; mode++)
+   {
+      uint64_t save_ns = 0, load_ns = 0, t;
+      uint32_t size    = 0;
+      int ok           = 1;
+
+      bench       = entries;
+      bench_count = 0;
+      bench_next  = 0;
+
+      for (i = 0; i < runs && ok; i++)
+      {
+         st.loc            = 0;
+         st.len            = 0;
+         st.fastsavestates = (mode != 0);
+         st.raw            = (mode == 2);
+
+         t        = BenchTime();
+         ok       = PX68KSS_SaveSM(&st, 0, 0, NULL, NULL, NULL);
+         save_ns += BenchTime() - t;
+      }
+      size = st.len;
+
+      for (i = 0; i < runs && ok; i++)
+      {
+         st.loc            = 0;
+         st.len            = size;
+         st.fastsavestates = (mode != 0);
+
+         bench_next = 0;
+         t          = BenchTime();
+         ok         = PX68KSS_LoadSM(&st, 0, 0);
+         load_ns   += BenchTime() - t;
+      }
+
+      bench = NULL;
+
+      if (!ok)
+      {
+         log_cb(RETRO_LOG_WARN, "state benchmark, %s: failed\n", modes[mode]);
+         continue;
+      }
+
+      log_cb(RETRO_LOG_INFO, "state benchmark, %s, %d runs: %u bytes, save %llu ns, load %llu ns\n",
+            modes[mode], runs, size,
+            (unsigned long long)(save_ns / runs),
+            (unsigned long long)(load_ns / runs));
+
+      for (i = 0; i < bench_count; i++)
+         log_cb(RETRO_LOG_INFO, "  %-20.32s %9u bytes  save %9llu ns  load %9llu ns\n",
+               entries[i].name, entries[i].bytes,
+               (unsigned long long)(entries[i].save_ns / runs),
+               (unsigned long long)(entries[i].load_ns / runs));
+   }
+
+   free(st.data);
+}
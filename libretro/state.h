@@ -24,8 +24,46 @@ typedef struct
     * Only used for internal savestates which will not be written to a file.
     */
    bool fastsavestates;
+
+   /* Only lays the state out: loc and len advance, nothing is copied */
+   bool sizeonly;
+
+   /* data is the caller's buffer of malloced bytes and is never grown;
+    * the save fails if the state does not fit */
+   bool fixedsize;
+
+   /* Paged memory only carries the pages written since the base copy.
+    * Such a state can only be loaded back into the same running core. */
+   bool delta;
+
+   /* Sections and variables are stored back to back as they are in
+    * memory, without names, sizes or byte order conversion.  Only the
+    * same build can load such a state. */
+   bool raw;
+
+   /* The state goes out LZ packed, in a container that
+    * PX68KSS_LoadSM unpacks on its own */
+   bool compress;
 } StateMem;
 
+/* Memory whose writers flag every page they touch */
+#define PX68KSTATE_PAGE_SHIFT 12
+#define PX68KSTATE_PAGE_SIZE  (1 << PX68KSTATE_PAGE_SHIFT)
+
+typedef struct
+{
+   uint8_t *mem;
+   uint8_t *dirty;      /* a flag per page, set by the writers */
+   uint32_t size;       /* in bytes, a multiple of the page size */
+   uint32_t keep;       /* full states hold this many bytes and then only
+                         * the pages that are not all zero */
+
+   /* Owned by state.c */
+   uint8_t *base;       /* mem as it was when the dirty flags were cleared */
+   uint8_t *prev;       /* the previous base, for the pages in prev_dirty */
+   uint8_t *prev_dirty; /* pages that differ between prev and base */
+} PX68KPages;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -33,6 +71,14 @@ extern "C" {
 int PX68KSS_SaveSM(void *st, int, int, const void*, const void*, const void*);
 int PX68KSS_LoadSM(void *st, int, int);
 
+/* Paged memory has to be known before a delta state is taken */
+void PX68KSS_AddPages(PX68KPages *p);
+void PX68KSS_FreePages(void);
+
+/* Logs the size of every section and the time taken to save and load
+ * it, averaged over runs saves and loads in each state layout */
+void PX68KSS_Benchmark(int runs);
+
 /* Flag for a single, >= 1 byte native-endian variable */
 #define PX68KSTATE_RLSB            0x80000000
 /* 32-bit native-endian elements */
@@ -43,6 +89,8 @@ int PX68KSS_LoadSM(void *st, int, int);
 #define PX68KSTATE_RLSB64          0x10000000
 
 #define PX68KSTATE_BOOL		  0x08000000
+/* v points to a PX68KPages */
+#define PX68KSTATE_PAGED           0x04000000
 
 typedef struct
 {
@@ -65,6 +113,8 @@ struct SSDescriptor
    const char *name;
 };
 
+/* Returns 0 on failure.  A section that is optional and missing from a
+ * loaded state leaves its variables as they are and returns -1. */
 int PX68KSS_StateAction(void *st, int load, int data_only, SFORMAT *sf, const char *name, bool optional);
 
 #ifdef __cplusplus
@@ -14,9 +14,18 @@
 #define SFARRAY32N(x, l, n) { (x), (uint32_t)((l) * sizeof(uint32_t)), PX68KSTATE_RLSB32, n }
 #define SFARRAY32(x, l) SFARRAY32N((x), (l), #x)
 
+#ifdef PX68K_XRGB8888
+#define SFARRAYPIX(x, l) SFARRAY32(x, l)
+#else
+#define SFARRAYPIX(x, l) SFARRAY16(x, l)
+#endif
+
 #define SFARRAY64N(x, l, n) { (x), (uint32_t)((l) * sizeof(uint64_t)), PX68KSTATE_RLSB64, n }
 #define SFARRAY64(x, l) SFARRAY64N((x), (l), #x)
 
+/* x is a PX68KPages, saved under the name of the plain array it replaces */
+#define SFPAGESN(x, n) { &(x), (x).size, PX68KSTATE_PAGED, n }
+
 #define SFEND { 0, 0, 0, 0 }
 
 #endif
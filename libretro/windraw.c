@@ -42,22 +42,40 @@
 #define		SCREEN_WIDTH		768
 #define		FULLSCREEN_WIDTH	800
 
-extern uint16_t *videoBuffer;
-uint16_t menu_buffer[800*600];
+extern pixel_t *videoBuffer;
+pixel_t menu_buffer[800*600];
 
 extern uint8_t Debug_Text, Debug_Grp, Debug_Sp;
 
-static uint16_t *ScrBuf = 0;
+static pixel_t *ScrBuf = 0;
 
-uint16_t WinDraw_Pal16B, WinDraw_Pal16R, WinDraw_Pal16G;
+pixel_t WinDraw_Pal16B, WinDraw_Pal16R, WinDraw_Pal16G;
+
+/* Output line width and the per-axis shifts applied by the reduced
+ * resolution mode.  The plane renderers sample every (1 << shift)-th dot. */
+uint32_t WinDraw_DotX = 768;
+uint8_t WinDraw_HShift = 0, WinDraw_VShift = 0;
+
+static void WinDraw_UpdateScale(void)
+{
+	WinDraw_HShift = ((Config.ReducedRes & 1) && (TextDotX >= 512)) ? 1 : 0;
+	WinDraw_VShift = ((Config.ReducedRes & 2) && (TextDotY >= 400)) ? 1 : 0;
+	WinDraw_DotX   = TextDotX >> WinDraw_HShift;
+}
 
 void WinDraw_Init(void)
 {
+#ifdef PX68K_XRGB8888
+	WinDraw_Pal16R = 0x00ff0000;
+	WinDraw_Pal16G = 0x0000ff00;
+	WinDraw_Pal16B = 0x000000ff;
+#else
 	WinDraw_Pal16R = 0xf800;
 	WinDraw_Pal16G = 0x07e0;
 	WinDraw_Pal16B = 0x001f;
+#endif
 
-	ScrBuf         = malloc(800 * 600 * 2);
+	ScrBuf         = malloc(800 * 600 * sizeof(pixel_t));
 }
 
 void WinDraw_Cleanup(void)
@@ -74,28 +92,35 @@ extern int CHANGEAV;
 void FASTCALL WinDraw_Draw(void)
 {
 	static int oldtextx = -1, oldtexty = -1;
+	int textx, texty;
+
+	WinDraw_UpdateScale();
+	textx = WinDraw_DotX;
+	texty = TextDotY >> WinDraw_VShift;
 
-	if (oldtextx != TextDotX)
+	if (oldtextx != textx)
 	{
-		oldtextx = TextDotX;
+		oldtextx = textx;
 		CHANGEAV=1;
 	}
-	if (oldtexty != TextDotY)
+	if (oldtexty != texty)
 	{
-		oldtexty = TextDotY;
+		oldtexty = texty;
 		CHANGEAV=1;
 	}
 
 	if (CHANGEAV==1)
 	{
-		retrow=TextDotX;
-		retroh=TextDotY;
+		retrow=textx;
+		retroh=texty;
 	}
 
-	videoBuffer = (uint16_t*)ScrBuf;
+	videoBuffer = ScrBuf;
 }
 
-#define WD_MEMCPY(src) memcpy(&ScrBuf[adr], (src), TextDotX * 2)
+#define WD_ADR ((VLINE >> WinDraw_VShift) * FULLSCREEN_WIDTH)
+
+#define WD_MEMCPY(src) memcpy(&ScrBuf[adr], (src), WinDraw_DotX * sizeof(pixel_t))
 
 #define WD_LOOP(start, end, sub)                 \
 	{                                            \
@@ -116,14 +141,14 @@ static INLINE void WinDraw_DrawGrpLine(int opaq)
 {
 #define _DGL_SUB(SUFFIX) WD_SUB(SUFFIX, Grp_LineBuf[i])
 
-	uint32_t adr = VLINE * FULLSCREEN_WIDTH;
-	uint16_t w;
+	uint32_t adr = WD_ADR;
+	pixel_t w;
 	int i;
 
 	if (opaq) {
 		WD_MEMCPY(Grp_LineBuf);
 	} else {
-		WD_LOOP(0,  TextDotX, _DGL_SUB);
+		WD_LOOP(0,  WinDraw_DotX, _DGL_SUB);
 	}
 }
 
@@ -131,14 +156,14 @@ static INLINE void WinDraw_DrawGrpLineNonSP(int opaq)
 {
 #define _DGL_NSP_SUB(SUFFIX) WD_SUB(SUFFIX, Grp_LineBufSP2[i])
 
-	uint32_t adr = VLINE*FULLSCREEN_WIDTH;
-	uint16_t w;
+	uint32_t adr = WD_ADR;
+	pixel_t w;
 	int i;
 
 	if (opaq) {
 		WD_MEMCPY(Grp_LineBufSP2);
 	} else {
-		WD_LOOP(0,  TextDotX, _DGL_NSP_SUB);
+		WD_LOOP(0,  WinDraw_DotX, _DGL_NSP_SUB);
 	}
 }
 
@@ -154,17 +179,17 @@ static INLINE void WinDraw_DrawTextLine(int opaq, int td)
 		}                       \
 	}
 
-	uint32_t adr = VLINE*FULLSCREEN_WIDTH;
-	uint16_t w;
+	uint32_t adr = WD_ADR;
+	pixel_t w;
 	int i;
 
 	if (opaq) {
 		WD_MEMCPY(&BG_LineBuf[16]);
 	} else {
 		if (td) {
-			WD_LOOP(16, TextDotX + 16, _DTL_SUB);
+			WD_LOOP(16, WinDraw_DotX + 16, _DTL_SUB);
 		} else {
-			WD_LOOP(16, TextDotX + 16, _DTL_SUB2);
+			WD_LOOP(16, WinDraw_DotX + 16, _DTL_SUB2);
 		}
 	}
 }
@@ -191,7 +216,7 @@ static INLINE void WinDraw_DrawTextLineTR(int opaq)
 			else                           \
 				v = 0;                     \
 		}                                  \
-		ScrBuf##SUFFIX[adr] = (uint16_t)v; \
+		ScrBuf##SUFFIX[adr] = (pixel_t)v;  \
 	}
 
 #define _DTL_TR_SUB2(SUFFIX)                       \
@@ -212,20 +237,20 @@ static INLINE void WinDraw_DrawTextLineTR(int opaq)
 					v += w;                        \
 					v >>= 1;                       \
 				}                                  \
-				ScrBuf##SUFFIX[adr] = (uint16_t)v; \
+				ScrBuf##SUFFIX[adr] = (pixel_t)v;  \
 			}                                      \
 		}                                          \
 	}
 
-	uint32_t adr = VLINE*FULLSCREEN_WIDTH;
+	uint32_t adr = WD_ADR;
 	uint32_t v;
-	uint16_t w;
+	pixel_t w;
 	int i;
 
 	if (opaq) {
-		WD_LOOP(16, TextDotX + 16, _DTL_TR_SUB);
+		WD_LOOP(16, WinDraw_DotX + 16, _DTL_TR_SUB);
 	} else {
-		WD_LOOP(16, TextDotX + 16, _DTL_TR_SUB2);
+		WD_LOOP(16, WinDraw_DotX + 16, _DTL_TR_SUB2);
 	}
 }
 
@@ -241,17 +266,17 @@ static INLINE void WinDraw_DrawBGLine(int opaq, int td)
 		}                       \
 	}
 
-	uint32_t adr = VLINE*FULLSCREEN_WIDTH;
-	uint16_t w;
+	uint32_t adr = WD_ADR;
+	pixel_t w;
 	int i;
 
 	if (opaq) {
 		WD_MEMCPY(&BG_LineBuf[16]);
 	} else {
 		if (td) {
-			WD_LOOP(16, TextDotX + 16, _DBL_SUB);
+			WD_LOOP(16, WinDraw_DotX + 16, _DBL_SUB);
 		} else {
-			WD_LOOP(16, TextDotX + 16, _DBL_SUB2);
+			WD_LOOP(16, WinDraw_DotX + 16, _DBL_SUB2);
 		}
 	}
 }
@@ -277,7 +302,7 @@ static INLINE void WinDraw_DrawBGLineTR(int opaq)
 		v = BG_LineBuf[i];                 \
                                            \
 		_DBL_TR_SUB3()                     \
-		ScrBuf##SUFFIX[adr] = (uint16_t)v; \
+		ScrBuf##SUFFIX[adr] = (pixel_t)v;  \
 	}
 
 #define _DBL_TR_SUB2(SUFFIX)                       \
@@ -290,20 +315,20 @@ static INLINE void WinDraw_DrawBGLineTR(int opaq)
 			if (v != 0)                            \
 			{                                      \
 				_DBL_TR_SUB3()                     \
-				ScrBuf##SUFFIX[adr] = (uint16_t)v; \
+				ScrBuf##SUFFIX[adr] = (pixel_t)v;  \
 			}                                      \
 		}                                          \
 	}
 
-	uint32_t adr = VLINE*FULLSCREEN_WIDTH;
+	uint32_t adr = WD_ADR;
 	uint32_t v;
-	uint16_t w;
+	pixel_t w;
 	int i;
 
 	if (opaq) {
-		WD_LOOP(16, TextDotX + 16, _DBL_TR_SUB);
+		WD_LOOP(16, WinDraw_DotX + 16, _DBL_TR_SUB);
 	} else {
-		WD_LOOP(16, TextDotX + 16, _DBL_TR_SUB2);
+		WD_LOOP(16, WinDraw_DotX + 16, _DBL_TR_SUB2);
 	}
 
 }
@@ -312,11 +337,11 @@ static INLINE void WinDraw_DrawPriLine(void)
 {
 #define _DPL_SUB(SUFFIX) WD_SUB(SUFFIX, Grp_LineBufSP[i])
 
-	uint32_t adr = VLINE*FULLSCREEN_WIDTH;
-	uint16_t w;
+	uint32_t adr = WD_ADR;
+	pixel_t w;
 	int i;
 
-	WD_LOOP(0, TextDotX, _DPL_SUB);
+	WD_LOOP(0, WinDraw_DotX, _DPL_SUB);
 }
 
 void WinDraw_DrawLine(void)
@@ -328,6 +353,10 @@ void WinDraw_DrawLine(void)
 	if (!TextDirtyLine[VLINE])
 		return;
 
+	WinDraw_UpdateScale();
+	if (WinDraw_VShift && (VLINE & 1))
+		return;
+
 	TextDirtyLine[VLINE] = 0;
 
 	if (Debug_Grp)
@@ -475,7 +504,7 @@ void WinDraw_DrawLine(void)
 			ton = 1;
 		}
 		else
-			memset(Text_TrFlag, 0, TextDotX+16);
+			memset(Text_TrFlag, 0, WinDraw_DotX+16);
 
 		if ((VCReg2[1]&0x40)&&(BG_Regs[8]&2)&&(!(BG_Regs[0x11]&2))&&(Debug_Sp))
 		{
@@ -501,7 +530,7 @@ void WinDraw_DrawLine(void)
 			VLINEBG <<= s1;
 			VLINEBG >>= s2;
 			if ( !(BG_Regs[0x11]&16) ) VLINEBG -= ((BG_Regs[0x0f]>>s1)-(CRTC_Regs[0x0d]>>s2));
-			memset(Text_TrFlag, 0, TextDotX+16);
+			memset(Text_TrFlag, 0, WinDraw_DotX+16);
 			BG_DrawLine(1, 1);
 			bgon = 1;
 		}
@@ -510,12 +539,12 @@ void WinDraw_DrawLine(void)
 			if ((VCReg2[1]&0x20)&&(Debug_Text))
 			{
 				int i;
-				for (i = 16; i < TextDotX + 16; ++i)
+				for (i = 16; i < WinDraw_DotX + 16; ++i)
 					BG_LineBuf[i] = TextPal[0];
 			} else {		/* 20010120 ῧ */
-				memset(&BG_LineBuf[16], 0, TextDotX * 2);
+				memset(&BG_LineBuf[16], 0, WinDraw_DotX * sizeof(pixel_t));
 			}
-			memset(Text_TrFlag, 0, TextDotX+16);
+			memset(Text_TrFlag, 0, WinDraw_DotX+16);
 			bgon = 1;
 		}
 
@@ -674,32 +703,87 @@ void WinDraw_DrawLine(void)
 #define _DL_SUB(SUFFIX)                                    \
 	{                                                      \
 		w = Grp_LineBufSP[i];                              \
-		if (w != 0 && (ScrBuf##SUFFIX[adr] & 0xffff) == 0) \
+		if (w != 0 && ScrBuf##SUFFIX[adr] == 0)            \
 			ScrBuf##SUFFIX[adr] = (w & Pal_HalfMask) >> 1; \
 	}
 
-		uint32_t adr = VLINE*FULLSCREEN_WIDTH;
-		uint16_t w;
+		uint32_t adr = WD_ADR;
+		pixel_t w;
 		int i;
 
-		WD_LOOP(0, TextDotX, _DL_SUB);
+		WD_LOOP(0, WinDraw_DotX, _DL_SUB);
 	}
 
 	if (opaq)
 	{
-		uint32_t adr = VLINE*FULLSCREEN_WIDTH;
-		memset(&ScrBuf[adr], 0, TextDotX * 2);
+		uint32_t adr = WD_ADR;
+		memset(&ScrBuf[adr], 0, WinDraw_DotX * sizeof(pixel_t));
+	}
+}
+
+/* Returns non-zero when every visible plane samples the same source data
+ * on both lines, so that their composites are bound to be identical. */
+static int WinDraw_LineSourceMatch(uint32_t line0, uint32_t line1)
+{
+	if ((VCReg2[1]&0x1f)&&(Debug_Grp))
+	{
+		if (!Grp_LineMatch(line0, line1))
+			return 0;
+	}
+	if ((VCReg2[1]&0x20)&&(Debug_Text))
+	{
+		if (!Text_LineMatch(line0, line1))
+			return 0;
+	}
+	if ((VCReg2[1]&0x40)&&(BG_Regs[8]&2)&&(!(BG_Regs[0x11]&2))&&(Debug_Sp))
+	{
+		int s1, s2;
+		s1 = (((BG_Regs[0x11]  &4)?2:1)-((BG_Regs[0x11]  &16)?1:0));
+		s2 = (((CRTC_Regs[0x29]&4)?2:1)-((CRTC_Regs[0x29]&16)?1:0));
+		if (((line0 << s1) >> s2) != ((line1 << s1) >> s2))
+			return 0;
+	}
+	return 1;
+}
+
+/* Draws VLINE and VLINE+1 for the interlaced 512 line modes.  The second
+ * line is copied from the first one instead of going through the plane
+ * pipeline again whenever both of them sample identical source rows. */
+void WinDraw_DrawLinePair(void)
+{
+	int drawn = (VLINE != (uint32_t)-1) && TextDirtyLine[VLINE];
+
+	WinDraw_DrawLine();
+	VLINE++;
+
+	if (drawn && !WinDraw_VShift && TextDirtyLine[VLINE] && WinDraw_LineSourceMatch(VLINE - 1, VLINE))
+	{
+		uint32_t adr = WD_ADR;
+		memcpy(&ScrBuf[adr], &ScrBuf[adr - FULLSCREEN_WIDTH], WinDraw_DotX * sizeof(pixel_t));
+		TextDirtyLine[VLINE] = 0;
+		return;
 	}
+
+	WinDraw_DrawLine();
 }
 
+/* Converts an RGB565 menu colour to the host pixel format */
+#ifdef PX68K_XRGB8888
+#define WD_COLOR(c) ((((c) & 0xf800) << 8) | (((c) & 0xe000) << 3) | \
+                     (((c) & 0x07e0) << 5) | (((c) & 0x0600) >> 1) | \
+                     (((c) & 0x001f) << 3) | (((c) & 0x001c) >> 2))
+#else
+#define WD_COLOR(c) (c)
+#endif
+
 /********** menu Ϣ롼 **********/
 
 struct _px68k_menu
 {
-	uint16_t *sbp;    /* surface buffer ptr */
-	uint16_t *mlp;    /* menu locate ptr */
-	uint16_t mcolor;  /* color of chars to write */
-	uint16_t mbcolor; /* back ground color of chars to write */
+	pixel_t *sbp;    /* surface buffer ptr */
+	pixel_t *mlp;    /* menu locate ptr */
+	pixel_t mcolor;  /* color of chars to write */
+	pixel_t mbcolor; /* back ground color of chars to write */
 	int ml_x;
 	int ml_y;
 	int mfs;      /* menu font size; */
@@ -796,52 +880,115 @@ static void set_mlocateC(int x, int y)
 	p6m.ml_x = x * p6m.mfs / 2, p6m.ml_y = y * p6m.mfs;
 }
 
-static uint16_t *get_ml_ptr(void)
+static pixel_t *get_ml_ptr(void)
 {
 	p6m.mlp = p6m.sbp + MENU_WIDTH * p6m.ml_y + p6m.ml_x;
 	return p6m.mlp;
 }
 
-/* Ⱦʸξ16bitξ8bit˥ǡƤ
- *   (ȾorѤȽǤǤ褦)
- * ɽʬcursor˰ư
- */
-static void draw_char(uint16_t sjis)
+/* Pre-rasterised glyphs in the colours they were last drawn with,
+ * recycled least recently used first. */
+#define MENU_GLYPHS 64
+
+struct menu_glyph
 {
-	int i, j, k, wc, w;
+	uint16_t sjis;
+	uint8_t  fs;
+	uint8_t  w;
+	pixel_t  fg, bg;
+	uint32_t last;     /* use stamp, 0 = empty slot */
+	uint32_t mask[24]; /* foreground dots of each row, MSB = leftmost */
+	pixel_t  pix[24 * 24];
+};
+
+static struct menu_glyph menu_glyphs[MENU_GLYPHS];
+static uint32_t menu_glyph_stamp;
+
+static struct menu_glyph *get_glyph(uint16_t sjis)
+{
+	struct menu_glyph *g, *lru = &menu_glyphs[0];
+	int i, j, k, x, wc, w;
+	int h = p6m.mfs;
+	uint32_t f;
 	uint8_t c;
-	uint16_t bc;
-	int h    = p6m.mfs;
-	uint16_t *p  = get_ml_ptr();
-	uint32_t f  = get_font_addr(sjis, h);
 
-	if (f < 0)
-		return;
+	for (i = 0; i < MENU_GLYPHS; i++) {
+		g = &menu_glyphs[i];
+		if (g->last && g->sjis == sjis && g->fs == h
+		 && g->fg == p6m.mcolor && g->bg == p6m.mbcolor) {
+			g->last = ++menu_glyph_stamp;
+			return g;
+		}
+		if (g->last < lru->last)
+			lru = g;
+	}
+
+	f = get_font_addr(sjis, h);
+	if (f == (uint32_t)-1)
+		return NULL;
 
 	/* h=8ȾѤΤ */
 	w = (h == 8)? 8 : (isHankaku(sjis >> 8)? h / 2 : h);
 
+	g       = lru;
+	g->sjis = sjis;
+	g->fs   = h;
+	g->w    = w;
+	g->fg   = p6m.mcolor;
+	g->bg   = p6m.mbcolor;
+	g->last = ++menu_glyph_stamp;
+
 	for (i = 0; i < h; i++) {
 		wc = w;
+		x  = 0;
+		g->mask[i] = 0;
 		for (j = 0; j < ((w % 8 == 0)? w / 8 : w / 8 + 1); j++) {
 			c = FONT[f++];
 			for (k = 0; k < 8 ; k++) {
-				bc = p6m.mbcolor? p6m.mbcolor : *p;
-				*p = (c & 0x80)? p6m.mcolor : bc;
-				p++;
+				if (c & 0x80)
+					g->mask[i] |= 0x80000000 >> x;
+				g->pix[i * 24 + x] = (c & 0x80)? g->fg : g->bg;
+				x++;
 				c = c << 1;
 				wc--;
 				if (wc == 0)
 					break;
 			}
 		}
-		p = p + MENU_WIDTH - w;
 	}
 
-	p6m.ml_x += w;
+	return g;
 }
 
-static void draw_str(char *cp)
+/* Ⱦʸξ16bitξ8bit˥ǡƤ
+ *   (ȾorѤȽǤǤ褦)
+ * ɽʬcursor˰ư
+ */
+static void draw_char(uint16_t sjis)
+{
+	int i, x;
+	int h    = p6m.mfs;
+	pixel_t *p  = get_ml_ptr();
+	struct menu_glyph *g = get_glyph(sjis);
+
+	if (!g)
+		return;
+
+	for (i = 0; i < h; i++, p += MENU_WIDTH) {
+		if (p6m.mbcolor)
+			memcpy(p, &g->pix[i * 24], g->w * sizeof(pixel_t));
+		else {
+			uint32_t m = g->mask[i];
+			for (x = 0; m; x++, m <<= 1)
+				if (m & 0x80000000)
+					p[x] = p6m.mcolor;
+		}
+	}
+
+	p6m.ml_x += g->w;
+}
+
+static void draw_str_now(char *cp)
 {
 	int i;
 	uint16_t wc;
@@ -867,11 +1014,114 @@ static void draw_str(char *cp)
 	}
 }
 
+/*
+ * WinDraw_ClearMenuBuffer() opens a redraw pass in which draw_str() only
+ * records what is drawn where.  menu_end_pass() then compares each text
+ * row with the previous pass and clears and redraws only the rows whose
+ * strings changed or that were painted over in between.
+ */
+#define MENU_OPS 64
+
+struct menu_op
+{
+	int x, y;
+	pixel_t fg, bg;
+	char str[256];
+};
+
+static struct menu_op menu_ops[2][MENU_OPS];
+static int menu_nops[2];
+static int menu_cur;          /* menu_ops[] index of the pass being recorded */
+static int menu_rec;          /* non-zero while a pass is being recorded */
+static int menu_pass_fs;      /* font size of the previous pass */
+static uint8_t menu_dirty[600];
+
+static void draw_str(char *cp)
+{
+	struct menu_op *op;
+	int y;
+
+	if (!menu_rec || menu_nops[menu_cur] == MENU_OPS) {
+		for (y = p6m.ml_y; y < p6m.ml_y + p6m.mfs && y < 600; y++)
+			menu_dirty[y] = 1;
+		draw_str_now(cp);
+		return;
+	}
+
+	op     = &menu_ops[menu_cur][menu_nops[menu_cur]++];
+	op->x  = p6m.ml_x;
+	op->y  = p6m.ml_y;
+	op->fg = p6m.mcolor;
+	op->bg = p6m.mbcolor;
+	strncpy(op->str, cp, sizeof(op->str) - 1);
+	op->str[sizeof(op->str) - 1] = '\0';
+}
+
+static int menu_row_same(int y)
+{
+	const struct menu_op *a = menu_ops[menu_cur], *b = menu_ops[menu_cur ^ 1];
+	const struct menu_op *ae = a + menu_nops[menu_cur], *be = b + menu_nops[menu_cur ^ 1];
+
+	for (;;) {
+		while (a < ae && a->y != y) a++;
+		while (b < be && b->y != y) b++;
+		if (a == ae || b == be)
+			return (a == ae) && (b == be);
+		if (a->x != b->x || a->fg != b->fg || a->bg != b->bg || strcmp(a->str, b->str))
+			return 0;
+		a++;
+		b++;
+	}
+}
+
+static void menu_end_pass(void)
+{
+	pixel_t fg = p6m.mcolor, bg = p6m.mbcolor;
+	int fs = p6m.mfs;
+	int i, y, r, redraw;
+
+	if (!menu_rec)
+		return;
+	menu_rec = 0;
+
+	if (fs != menu_pass_fs) {
+		memset(menu_dirty, 1, sizeof(menu_dirty));
+		menu_nops[menu_cur ^ 1] = 0;
+		menu_pass_fs = fs;
+	}
+
+	for (y = 0; y < 600; y += fs) {
+		redraw = !menu_row_same(y);
+		for (r = y; r < y + fs && r < 600; r++) {
+			redraw |= menu_dirty[r];
+			menu_dirty[r] = 0;
+		}
+		if (!redraw)
+			continue;
+
+		memset(&menu_buffer[y * MENU_WIDTH], 0, ((r - y) * MENU_WIDTH) * sizeof(pixel_t));
+		for (i = 0; i < menu_nops[menu_cur]; i++) {
+			const struct menu_op *op = &menu_ops[menu_cur][i];
+			if (op->y != y)
+				continue;
+			p6m.ml_x    = op->x;
+			p6m.ml_y    = op->y;
+			p6m.mcolor  = op->fg;
+			p6m.mbcolor = op->bg;
+			draw_str_now((char *)op->str);
+		}
+	}
+
+	p6m.mcolor  = fg;
+	p6m.mbcolor = bg;
+	menu_cur ^= 1;
+}
+
 int WinDraw_MenuInit(void)
 {
 	p6m.sbp     = menu_buffer;
 	p6m.mfs     = 16;
-	p6m.mcolor  = 0xffff;
+	p6m.mcolor  = WD_COLOR(0xffff);
 	p6m.mbcolor = 0;
 	return 1;
 }
@@ -894,7 +1144,7 @@ void WinDraw_DrawMenu(int menu_state, int mkey_pos, int mkey_y, int *mval_y)
 	p6m.mfs     = Config.MenuFontSize ? 24 : 16;
 
 	/* ȥ */
-	p6m.mcolor  = 0x07ff; /* cyan */
+	p6m.mcolor  = WD_COLOR(0x07ff); /* cyan */
 	set_mlocateC(0, 0);
 	draw_str(twaku_str);
 	set_mlocateC(0, 1);
@@ -902,17 +1152,17 @@ void WinDraw_DrawMenu(int menu_state, int mkey_pos, int mkey_y, int *mval_y)
 	set_mlocateC(0, 2);
 	draw_str(twaku3_str);
 
-	p6m.mcolor  = 0xffff;
+	p6m.mcolor  = WD_COLOR(0xffff);
 	set_mlocateC(2, 1);
         strcpy(tmp, title_str);
         strcat(tmp, PX68KVERSTR);
 	draw_str(tmp);
 
 	
-	p6m.mcolor  = 0xffff; /*  */
+	p6m.mcolor  = WD_COLOR(0xffff); /*  */
 
 	/*  */
-	p6m.mcolor  = 0xffe0; /* yellow */
+	p6m.mcolor  = WD_COLOR(0xffe0); /* yellow */
 	set_mlocateC(1, 4);
 	draw_str(waku_str);
 	for (i = 5; i < 10; i++)
@@ -924,25 +1174,25 @@ void WinDraw_DrawMenu(int menu_state, int mkey_pos, int mkey_y, int *mval_y)
 	draw_str(waku3_str);
 
 	/* ƥ/ */
-	p6m.mcolor = 0xffff;
+	p6m.mcolor = WD_COLOR(0xffff);
 	for (i = 0; i < 5; i++)
 	{
 		set_mlocateC(3, 5 + i);
 		if (menu_state == MS_KEY && i == (mkey_y - mkey_pos))
 		{
 			p6m.mcolor  = 0x0;
-			p6m.mbcolor = 0xffe0;
+			p6m.mbcolor = WD_COLOR(0xffe0);
 		}
 		else
 		{
-			p6m.mcolor  = 0xffff;
+			p6m.mcolor  = WD_COLOR(0xffff);
 			p6m.mbcolor = 0x0;
 		}
 		draw_str(menu_item_key[i + mkey_pos]);
 	}
 
 	/* ƥ/ */
-	p6m.mcolor  = 0xffff;
+	p6m.mcolor  = WD_COLOR(0xffff);
 	p6m.mbcolor = 0x0;
 	for (i = 0; i < 5; i++)
 	{
@@ -951,11 +1201,11 @@ void WinDraw_DrawMenu(int menu_state, int mkey_pos, int mkey_y, int *mval_y)
                && i == (mkey_y - mkey_pos))
 		{
 			p6m.mcolor  = 0x0;
-			p6m.mbcolor = 0xffe0;
+			p6m.mbcolor = WD_COLOR(0xffe0);
 		}
 		else
 		{
-			p6m.mcolor  = 0xffff;
+			p6m.mcolor  = WD_COLOR(0xffff);
 			p6m.mbcolor = 0x0;
 		}
 		set_mlocateC(17, 5 + i);
@@ -988,7 +1238,7 @@ void WinDraw_DrawMenu(int menu_state, int mkey_pos, int mkey_y, int *mval_y)
 	}
 
 	/*  */
-	p6m.mcolor  = 0x07ff; /* cyan */
+	p6m.mcolor  = WD_COLOR(0x07ff); /* cyan */
 	p6m.mbcolor = 0x0;
 	set_mlocateC(0, 11);
 	draw_str(swaku_str);
@@ -998,12 +1248,13 @@ void WinDraw_DrawMenu(int menu_state, int mkey_pos, int mkey_y, int *mval_y)
 	draw_str(swaku3_str);
 
 	/* ץ */
-	p6m.mcolor  = 0xffff;
+	p6m.mcolor  = WD_COLOR(0xffff);
 	p6m.mbcolor = 0x0;
 	set_mlocateC(2, 12);
 	draw_str(menu_item_desc[mkey_y]);
 
-	videoBuffer=(uint16_t*)menu_buffer;
+	menu_end_pass();
+	videoBuffer=menu_buffer;
 
 }
 
@@ -1012,13 +1263,15 @@ void WinDraw_DrawMenufile(struct menu_flist *mfl)
 	int i;
 	char ptr[PATH_MAX];
 
+	menu_end_pass();
+
    /* 0xf800 - red */
 	/* 0xf81f - magenta */
 
 	/* bottom frame */
 
-	p6m.mcolor  = 0xffff;
-	p6m.mbcolor = 0x1; /* 0 means transparent */
+	p6m.mcolor  = WD_COLOR(0xffff);
+	p6m.mbcolor = WD_COLOR(0x1); /* 0 means transparent */
 	set_mlocateC(1, 1);
 	draw_str(swaku_str);
 	for (i = 2; i < 16; i++)
@@ -1036,12 +1289,12 @@ void WinDraw_DrawMenufile(struct menu_flist *mfl)
 		if (i == mfl->y)
 		{
 			p6m.mcolor  = 0x0;
-			p6m.mbcolor = 0xffff;
+			p6m.mbcolor = WD_COLOR(0xffff);
 		}
 		else
 		{
-			p6m.mcolor  = 0xffff;
-			p6m.mbcolor = 0x1;
+			p6m.mcolor  = WD_COLOR(0xffff);
+			p6m.mbcolor = WD_COLOR(0x1);
 		}
 		/* enclose directory in '[ ]' */
 		set_mlocateC(3, i + 2);
@@ -1056,10 +1309,12 @@ void WinDraw_DrawMenufile(struct menu_flist *mfl)
 
 	p6m.mbcolor = 0x0; /* switch back to transparent mode */
 
-	videoBuffer=(uint16_t*)menu_buffer;
+	videoBuffer=menu_buffer;
 }
 
+/* Starts a menu redraw pass; rows that end up unchanged are not touched */
 void WinDraw_ClearMenuBuffer(void)
 {
-	memset(menu_buffer, 0, 800*600*2);
+	menu_nops[menu_cur] = 0;
+	menu_rec = 1;
 }
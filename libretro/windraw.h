@@ -2,13 +2,17 @@
 #define _WINX68K_WINDRAW_H
 
 #include <stdint.h>
+#include "common.h"
 
-extern uint16_t WinDraw_Pal16B, WinDraw_Pal16R, WinDraw_Pal16G;
+extern pixel_t WinDraw_Pal16B, WinDraw_Pal16R, WinDraw_Pal16G;
+extern uint32_t WinDraw_DotX;
+extern uint8_t WinDraw_HShift, WinDraw_VShift;
 
 void WinDraw_Init(void);
 void WinDraw_Cleanup(void);
 void FASTCALL WinDraw_Draw(void);
 void WinDraw_DrawLine(void);
+void WinDraw_DrawLinePair(void);
 
 int WinDraw_MenuInit(void);
 void WinDraw_DrawMenu(int menu_state, int mkey_pos, int mkey_y, int *mval_y);
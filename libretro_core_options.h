@@ -257,6 +257,37 @@ struct retro_core_option_v2_definition option_defs_us[] = {
       },
       "12"
    },
+   {
+      "px68k_sample_rate",
+      "Audio Sample Rate (Restart)",
+      NULL,
+      "Sets the rate all sound sources are mixed and output at. Lower rates reduce the cost of sound synthesis; 48000 Hz saves a resampling step in frontends running at that rate.",
+      NULL,
+      "audio",
+      {
+         { "22050", NULL },
+         { "32000", NULL },
+         { "44100", NULL },
+         { "48000", NULL },
+         { NULL,    NULL },
+      },
+      "44100"
+   },
+   {
+      "px68k_opm_rate",
+      "OPM Synthesis Rate (Restart)",
+      NULL,
+      "Sets the rate the OPM (YM2151) sound chip is computed at. 'Native' runs it at its own 62.5 kHz so envelopes, LFO and noise step exactly like the hardware, and converts the result to the output rate with a polyphase filter. 'Half Native' does the same at 31.25 kHz for slower devices.",
+      NULL,
+      "audio",
+      {
+         { "Output Rate", NULL },
+         { "Native",      NULL },
+         { "Half Native", NULL },
+         { NULL,          NULL },
+      },
+      "Output Rate"
+   },
 #ifndef NO_MERCURY
    {
       "px68k_mercury_vol",
@@ -412,6 +443,35 @@ struct retro_core_option_v2_definition option_defs_us[] = {
       },
       "Full Frame"
    },
+   {
+      "px68k_frameskip_threshold",
+      "Auto Frame Skip Threshold (%)",
+      NULL,
+      "With 'Auto Frame Skip', frames are skipped while the frontend's audio buffer is filled less than this. 'Underrun' skips only when the frontend expects the buffer to run dry. Frontends that do not report their audio buffer fall back to timing each frame.",
+      NULL,
+      "advanced",
+      {
+         { "Underrun", NULL },
+         { "15",       NULL },
+         { "18",       NULL },
+         { "21",       NULL },
+         { "24",       NULL },
+         { "27",       NULL },
+         { "30",       NULL },
+         { "33",       NULL },
+         { "36",       NULL },
+         { "39",       NULL },
+         { "42",       NULL },
+         { "45",       NULL },
+         { "48",       NULL },
+         { "51",       NULL },
+         { "54",       NULL },
+         { "57",       NULL },
+         { "60",       NULL },
+         { NULL,       NULL },
+      },
+      "Underrun"
+   },
    {
       "px68k_push_video_before_audio",
       "Push Video before Audio",
@@ -454,6 +514,143 @@ struct retro_core_option_v2_definition option_defs_us[] = {
       },
       "disabled"
    },
+   {
+      "px68k_reduced_resolution",
+      "Reduced Resolution",
+      NULL,
+      "Render 512 and 768 dot wide modes at half width and/or 400 and 512 line modes at half height by sampling every other dot and line. Saves rendering time on low-power devices with small displays at the expense of detail.",
+      NULL,
+      "advanced",
+      {
+         { "disabled",              NULL },
+         { "Half Width",            NULL },
+         { "Half Height",           NULL },
+         { "Half Width and Height", NULL },
+         { NULL,                    NULL },
+      },
+      "disabled"
+   },
+#ifdef PX68K_AUDIO_THREAD
+   {
+      "px68k_audio_thread",
+      "Threaded FM Synthesis",
+      NULL,
+      "Render the OPM (YM2151) sound chip on a separate thread while the CPU is emulated. Output is unchanged; uses a second core on multi-core hosts.",
+      NULL,
+      "advanced",
+      {
+         { "disabled", NULL},
+         { "enabled",  NULL},
+         { NULL,       NULL },
+      },
+      "disabled"
+   },
+#endif
+   {
+      "px68k_incremental_states",
+      "Incremental Run-Ahead States",
+      NULL,
+      "Run-ahead and preemptive frames states only carry the RAM and VRAM pages written since a base copy kept by the core, instead of all 12 MB of RAM. Such states cannot be loaded once the core has moved on by two bases, so rewinding far back fails while this is enabled.",
+      NULL,
+      "advanced",
+      {
+         { "disabled", NULL},
+         { "enabled",  NULL},
+         { NULL,       NULL },
+      },
+      "disabled"
+   },
+   {
+      "px68k_compress_states",
+      "Compressed Save States",
+      NULL,
+      "Save states are packed to a few hundred KB instead of about 5 MB, at about three times the time to save. The frontend's rewind and run-ahead save states the same way, so leave this disabled when using them.",
+      NULL,
+      "advanced",
+      {
+         { "disabled", NULL},
+         { "enabled",  NULL},
+         { NULL,       NULL },
+      },
+      "disabled"
+   },
+   {
+      "px68k_rewind_buffer",
+      "In-Core Rewind Buffer (MB)",
+      NULL,
+      "Keep a history of states inside the core, stored as compressed differences, and step back through it while L3 is held. Independent of the frontend's rewind.",
+      NULL,
+      "advanced",
+      {
+         { "disabled", NULL},
+         { "16",       NULL},
+         { "32",       NULL},
+         { "64",       NULL},
+         { "128",      NULL},
+         { "256",      NULL},
+         { "512",      NULL},
+         { NULL,       NULL },
+      },
+      "disabled"
+   },
+   {
+      "px68k_rewind_granularity",
+      "In-Core Rewind Granularity (Frames)",
+      NULL,
+      "Frames between the states kept by the in-core rewind. Each step back while L3 is held goes back this far; larger values reach further back in the same buffer.",
+      NULL,
+      "advanced",
+      {
+         { "1",  NULL},
+         { "2",  NULL},
+         { "3",  NULL},
+         { "4",  NULL},
+         { "5",  NULL},
+         { "6",  NULL},
+         { "10", NULL},
+         { "15", NULL},
+         { "20", NULL},
+         { "30", NULL},
+         { "60", NULL},
+         { NULL, NULL },
+      },
+      "1"
+   },
+   {
+      "px68k_boot_cache",
+      "Boot Cache (Frames)",
+      NULL,
+      "Store the machine this many frames after a cold start, and load it on later launches with the same ROMs, disk images, CPU speed, RAM size and sound settings instead of booting again. The state is kept in the save directory.",
+      NULL,
+      "advanced",
+      {
+         { "disabled", NULL},
+         { "300",      NULL},
+         { "600",      NULL},
+         { "900",      NULL},
+         { "1200",     NULL},
+         { "1800",     NULL},
+         { "3600",     NULL},
+         { NULL,       NULL },
+      },
+      "disabled"
+   },
+   {
+      "px68k_state_benchmark",
+      "Savestate Benchmark (Runs)",
+      NULL,
+      "Debugging aid. Once after this is set, save and load the machine this many times in each state layout and write the size of every section and the average time spent on it to the log.",
+      NULL,
+      "advanced",
+      {
+         { "disabled", NULL},
+         { "10",       NULL},
+         { "100",      NULL},
+         { "1000",     NULL},
+         { NULL,       NULL },
+      },
+      "disabled"
+   },
    {
       "px68k_text_off",
       "Text Off",
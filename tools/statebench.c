@@ -0,0 +1,177 @@
+/*
+ * STATEBENCH.C - Savestate benchmark without a frontend
+ *
+ * Loads the core, runs it headless for a number of frames and then sets
+ * the px68k_state_benchmark option, so that PX68KSS_Benchmark() saves and
+ * loads the machine in each state layout and logs what every section
+ * costs.  Built by "make statebench"; "make benchmark" runs it.
+ *
+ *    statebench CORE SYSTEM_DIR [FRAMES [RUNS [CONTENT]]]
+ *
+ * SYSTEM_DIR holds keropi/iplrom.dat and keropi/cgrom.dat and also takes
+ * the core's saves.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <dlfcn.h>
+
+#include <libretro.h>
+
+static const char *system_dir;
+static char bench_runs[16];
+static bool bench_set = false;    /* option changed, not yet seen by the core */
+static bool bench_on  = false;
+static retro_frame_time_callback_t frame_time_cb;
+
+static void log_printf(enum retro_log_level level, const char *fmt, ...)
+{
+   va_list ap;
+
+   if (level < RETRO_LOG_INFO)
+      return;
+   va_start(ap, fmt);
+   vfprintf(level >= RETRO_LOG_WARN ? stderr : stdout, fmt, ap);
+   va_end(ap);
+}
+
+static bool environment(unsigned cmd, void *data)
+{
+   switch (cmd)
+   {
+      case RETRO_ENVIRONMENT_GET_LOG_INTERFACE:
+         ((struct retro_log_callback *)data)->log = log_printf;
+         return true;
+      case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
+      case RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY:
+         *(const char **)data = system_dir;
+         return true;
+      case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
+      case RETRO_ENVIRONMENT_SET_GEOMETRY:
+      case RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO:
+         return true;
+      case RETRO_ENVIRONMENT_SET_FRAME_TIME_CALLBACK:
+         frame_time_cb = ((struct retro_frame_time_callback *)data)->callback;
+         return true;
+      case RETRO_ENVIRONMENT_GET_CORE_OPTIONS_VERSION:
+         *(unsigned *)data = 0;
+         return true;
+      case RETRO_ENVIRONMENT_GET_VARIABLE:
+         {
+            struct retro_variable *var = (struct retro_variable *)data;
+
+            /* everything else at its default */
+            if (strcmp(var->key, "px68k_state_benchmark"))
+               return false;
+            var->value = bench_on ? bench_runs : "disabled";
+         }
+         return true;
+      case RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE:
+         *(bool *)data = bench_set;
+         bench_set     = false;
+         return true;
+      default:
+         break;
+   }
+
+   return false;
+}
+
+static void video_refresh(const void *data, unsigned width, unsigned height, size_t pitch) { }
+static size_t audio_batch(const int16_t *data, size_t frames) { return frames; }
+static void audio_sample(int16_t left, int16_t right) { }
+static void input_poll(void) { }
+static int16_t input_state(unsigned port, unsigned device, unsigned index, unsigned id) { return 0; }
+
+#define SYM(type, name) \
+   if (!(name = (type)dlsym(core, #name))) \
+   { \
+      fprintf(stderr, "statebench: %s: no %s\n", argv[1], #name); \
+      return 1; \
+   }
+
+int main(int argc, char **argv)
+{
+   void (*retro_set_environment)(retro_environment_t);
+   void (*retro_set_video_refresh)(retro_video_refresh_t);
+   void (*retro_set_audio_sample)(retro_audio_sample_t);
+   void (*retro_set_audio_sample_batch)(retro_audio_sample_batch_t);
+   void (*retro_set_input_poll)(retro_input_poll_t);
+   void (*retro_set_input_state)(retro_input_state_t);
+   void (*retro_init)(void);
+   bool (*retro_load_game)(const struct retro_game_info *);
+   void (*retro_run)(void);
+   void (*retro_unload_game)(void);
+   void (*retro_deinit)(void);
+   struct retro_game_info game;
+   void *core;
+   int frames = 600;
+   int i;
+
+   if (argc < 3)
+   {
+      fprintf(stderr, "usage: statebench CORE SYSTEM_DIR [FRAMES [RUNS [CONTENT]]]\n");
+      return 1;
+   }
+   system_dir = argv[2];
+   if (argc > 3)
+      frames = atoi(argv[3]);
+   snprintf(bench_runs, sizeof(bench_runs), "%d", argc > 4 ? atoi(argv[4]) : 100);
+
+   if (!(core = dlopen(argv[1], RTLD_NOW)))
+   {
+      fprintf(stderr, "statebench: %s\n", dlerror());
+      return 1;
+   }
+   SYM(void (*)(retro_environment_t), retro_set_environment);
+   SYM(void (*)(retro_video_refresh_t), retro_set_video_refresh);
+   SYM(void (*)(retro_audio_sample_t), retro_set_audio_sample);
+   SYM(void (*)(retro_audio_sample_batch_t), retro_set_audio_sample_batch);
+   SYM(void (*)(retro_input_poll_t), retro_set_input_poll);
+   SYM(void (*)(retro_input_state_t), retro_set_input_state);
+   SYM(void (*)(void), retro_init);
+   SYM(bool (*)(const struct retro_game_info *), retro_load_game);
+   SYM(void (*)(void), retro_run);
+   SYM(void (*)(void), retro_unload_game);
+   SYM(void (*)(void), retro_deinit);
+
+   retro_set_environment(environment);
+   retro_set_video_refresh(video_refresh);
+   retro_set_audio_sample(audio_sample);
+   retro_set_audio_sample_batch(audio_batch);
+   retro_set_input_poll(input_poll);
+   retro_set_input_state(input_state);
+   retro_init();
+
+   memset(&game, 0, sizeof(game));
+   game.path = argc > 5 ? argv[5] : NULL;
+   if (!retro_load_game(game.path ? &game : NULL))
+   {
+      fprintf(stderr, "statebench: cannot load %s\n", game.path ? game.path : "the core");
+      return 1;
+   }
+
+   /* the first frame only sets the machine up */
+   for (i = 0; i <= frames; i++)
+   {
+      if (frame_time_cb)
+         frame_time_cb(1000000 / 55);
+      retro_run();
+   }
+
+   /* the core takes the option up on the next frame and benchmarks
+    * straight after emulating it */
+   bench_on  = true;
+   bench_set = true;
+   if (frame_time_cb)
+      frame_time_cb(1000000 / 55);
+   retro_run();
+
+   retro_unload_game();
+   retro_deinit();
+   dlclose(core);
+
+   return 0;
+}
@@ -43,6 +43,8 @@ static int16_t ADPCM_BufL[ADPCM_BufSize];
 static int32_t  ADPCM_WrPtr = 0;
 static int32_t  ADPCM_RdPtr = 0;
 static uint32_t ADPCM_SampleRate = 44100*12;
+/* interpolation position for each ADPCM_Count/100 below ADPCM_SampleRate */
+static uint8_t ADPCM_Ratio[48000*12/100];
 static uint32_t ADPCM_ClockRate = 7800*12;
 static uint32_t ADPCM_Count = 0;
 static int ADPCM_Step = 0;
@@ -59,13 +61,18 @@ static int OutsIp[4];
 static int OutsIpR[4];
 static int OutsIpL[4];
 
+/*
+ * Only the samples from ADPCM_RdPtr up to ADPCM_WrPtr are live.  They are
+ * saved as up to two runs, the second one after the buffer wraps, and
+ * loaded back to the start of the buffers.
+ */
 int ADPCM_StateAction(StateMem *sm, int load, int data_only)
 {
+	uint32_t run[2] = { 0, 0 };
 	SFORMAT StateRegs[] = 
 	{
 		/* TODO: Some of the vars might not be necessary */
-		SFARRAY16(ADPCM_BufL, 96000),
-		SFARRAY16(ADPCM_BufR, 96000),
+		SFARRAY32N(run, 2, "ADPCM_Live"),
 
 		SFVAR(ADPCM_VolumeShift),
 		SFVAR(ADPCM_WrPtr),
@@ -92,7 +99,61 @@ int ADPCM_StateAction(StateMem *sm, int load, int data_only)
 		SFEND
 	};
 
-	int ret = PX68KSS_StateAction(sm, load, data_only, StateRegs, "X68K_ADPC", false);
+	int ret;
+
+	if (sm->sizeonly)
+	{
+		/* the most the window can hold, in two runs */
+		run[0] = ADPCM_BufSize - 2;
+		run[1] = 1;
+	}
+	else if (!load && ADPCM_WrPtr >= ADPCM_RdPtr)
+		run[0] = ADPCM_WrPtr - ADPCM_RdPtr;
+	else if (!load)
+	{
+		run[0] = ADPCM_BufSize - ADPCM_RdPtr;
+		run[1] = ADPCM_WrPtr;
+	}
+
+	ret = PX68KSS_StateAction(sm, load, data_only, StateRegs, "X68K_ADPC", false);
+
+	if (run[0] >= ADPCM_BufSize || run[1] >= ADPCM_BufSize - run[0])
+		return 0;
+
+	{
+		uint32_t start = load ? 0 : ADPCM_RdPtr;
+		uint32_t wrap  = load ? run[0] : 0;
+		SFORMAT LiveRegs[] =
+		{
+			SFARRAY16N(&ADPCM_BufL[start], run[0], "ADPCM_LiveL0"),
+			SFARRAY16N(&ADPCM_BufR[start], run[0], "ADPCM_LiveR0"),
+			SFARRAY16N(&ADPCM_BufL[wrap], run[1], "ADPCM_LiveL1"),
+			SFARRAY16N(&ADPCM_BufR[wrap], run[1], "ADPCM_LiveR1"),
+
+			SFEND
+		};
+		/* states from before the live window had whole buffers */
+		SFORMAT OldRegs[] =
+		{
+			SFARRAY16(ADPCM_BufL, ADPCM_BufSize),
+			SFARRAY16(ADPCM_BufR, ADPCM_BufSize),
+
+			SFEND
+		};
+
+		int live = PX68KSS_StateAction(sm, load, data_only, LiveRegs, "X68K_ADPCW", true);
+
+		if (live > 0)
+		{
+			if (load)
+			{
+				ADPCM_RdPtr = 0;
+				ADPCM_WrPtr = run[0] + run[1];
+			}
+		}
+		else if (!live || !PX68KSS_StateAction(sm, load, data_only, OldRegs, "X68K_ADPC", false))
+			ret = 0;
+	}
 
 	return ret;
 }
@@ -138,7 +199,9 @@ void FASTCALL ADPCM_PreUpdate(uint32_t clock)
 	}
 }
 
-void ADPCM_Update(int16_t *buffer, size_t length, uint8_t *pbsp, uint8_t *pbep)
+/* First stage of the mixing bus: stores (rather than adds) unclamped
+ * samples, the other sources are added on top */
+void ADPCM_Update(int32_t *buffer, size_t length)
 {
 	int outs;
 	int32_t outl, outr;
@@ -149,10 +212,6 @@ void ADPCM_Update(int16_t *buffer, size_t length, uint8_t *pbsp, uint8_t *pbep)
    {
       while ( length )
       {
-         int tmpl, tmpr;
-         if (buffer >= (int16_t *)pbep)
-            buffer = (int16_t*)pbsp;
-
          if ( (ADPCM_WrPtr==ADPCM_RdPtr)&&(!(DMA[3].CCR&0x40)) )
             DMA_Exec(3);
          if ( ADPCM_WrPtr!=ADPCM_RdPtr )
@@ -193,18 +252,8 @@ void ADPCM_Update(int16_t *buffer, size_t length, uint8_t *pbsp, uint8_t *pbep)
          OutsIpL[2] = OutsIpL[3];
          OutsIpL[3] = outs;
 
-         tmpr = INTERPOLATE(OutsIpR, 0);
-         if ( tmpr>32767 )
-            tmpr = 32767;
-         else if ( tmpr<(-32768) )
-            tmpr = -32768;
-         *(buffer++) = (int16_t)tmpr;
-         tmpl = INTERPOLATE(OutsIpL, 0);
-         if ( tmpl>32767 )
-            tmpl = 32767;
-         else if ( tmpl<(-32768) )
-            tmpl = -32768;
-         *(buffer++) = (int16_t)tmpl;
+         *(buffer++) = OutsIpR[1];	/* INTERPOLATE(OutsIpR, 0) */
+         *(buffer++) = OutsIpL[1];	/* INTERPOLATE(OutsIpL, 0) */
          length--;
       }
    }
@@ -212,10 +261,6 @@ void ADPCM_Update(int16_t *buffer, size_t length, uint8_t *pbsp, uint8_t *pbep)
    {
       while ( length )
       {
-         int tmpl, tmpr;
-         if (buffer >= (int16_t *)pbep)
-            buffer = (int16_t*)pbsp;
-
          if ( (ADPCM_WrPtr==ADPCM_RdPtr)&&(!(DMA[3].CCR&0x40)) )
             DMA_Exec(3);
          if ( ADPCM_WrPtr!=ADPCM_RdPtr )
@@ -246,18 +291,8 @@ void ADPCM_Update(int16_t *buffer, size_t length, uint8_t *pbsp, uint8_t *pbep)
          OutsIpL[2] = OutsIpL[3];
          OutsIpL[3] = outs;
 
-         tmpr = INTERPOLATE(OutsIpR, 0);
-         if ( tmpr>32767 )
-            tmpr = 32767;
-         else if ( tmpr<(-32768) )
-            tmpr = -32768;
-         *(buffer++) = (int16_t)tmpr;
-         tmpl = INTERPOLATE(OutsIpL, 0);
-         if ( tmpl>32767 )
-            tmpl = 32767;
-         else if ( tmpl<(-32768) )
-            tmpl = -32768;
-         *(buffer++) = (int16_t)tmpl;
+         *(buffer++) = OutsIpR[1];	/* INTERPOLATE(OutsIpR, 0) */
+         *(buffer++) = OutsIpL[1];	/* INTERPOLATE(OutsIpL, 0) */
          length--;
       }
    }
@@ -293,22 +328,31 @@ static INLINE void ADPCM_WriteOne(uint8_t val)
       OutsIp[3] = ADPCM_Out;
    }
 
-	while ( ADPCM_SampleRate>ADPCM_Count ) {
-		if ( ADPCM_Playing ) {
-			int ratio = (((ADPCM_Count/100)*FM_IPSCALE)/(ADPCM_SampleRate/100));
-			int tmp = INTERPOLATE(OutsIp, ratio);
+	if ( ADPCM_Playing )
+	{
+		/* INTERPOLATE(OutsIp, x) with the terms that do not depend on x
+		 * taken out of the loop */
+		const long a = -OutsIp[0]+3*OutsIp[1]-3*OutsIp[2]+OutsIp[3];
+		const long b = 3*(OutsIp[0]-2*OutsIp[1]+OutsIp[2]);
+		const long c = -2*OutsIp[0]-3*OutsIp[1]+6*OutsIp[2]-OutsIp[3];
+		const int maskr = (ADPCM_Pan&1) ? 0 : ~0;
+		const int maskl = (ADPCM_Pan&2) ? 0 : ~0;
+
+		while ( ADPCM_SampleRate>ADPCM_Count ) {
+			long x = ADPCM_Ratio[ADPCM_Count/100];
+			int tmp = (int)(((((a*x + FM_IPSCALE/2)/FM_IPSCALE + b)*x + FM_IPSCALE/2)/FM_IPSCALE
+					+ c)*x + 3*FM_IPSCALE)/(6*FM_IPSCALE) + OutsIp[1];
 			if ( tmp>ADPCMMAX ) tmp = ADPCMMAX; else if ( tmp<ADPCMMIN ) tmp = ADPCMMIN;
-			if ( !(ADPCM_Pan&1) )
-				ADPCM_BufR[ADPCM_WrPtr] = (int16_t)tmp;
-			else
-				ADPCM_BufR[ADPCM_WrPtr] = 0;
-			if ( !(ADPCM_Pan&2) )
-				ADPCM_BufL[ADPCM_WrPtr++] = (int16_t)tmp;
-			else
-				ADPCM_BufL[ADPCM_WrPtr++] = 0;
+			ADPCM_BufR[ADPCM_WrPtr] = (int16_t)(tmp & maskr);
+			ADPCM_BufL[ADPCM_WrPtr++] = (int16_t)(tmp & maskl);
 			if ( ADPCM_WrPtr>=ADPCM_BufSize ) ADPCM_WrPtr = 0;
+			ADPCM_Count += ADPCM_ClockRate;
 		}
-		ADPCM_Count += ADPCM_ClockRate;
+	}
+	else
+	{
+		while ( ADPCM_SampleRate>ADPCM_Count )
+			ADPCM_Count += ADPCM_ClockRate;
 	}
 	ADPCM_Count -= ADPCM_SampleRate;
 }
@@ -381,12 +425,16 @@ void ADPCM_SetClock(int n)
 
 void ADPCM_Init(void)
 {
+	uint32_t i;
+
 	ADPCM_WrPtr      = 0;
 	ADPCM_RdPtr      = 0;
 	ADPCM_Out        = 0;
 	ADPCM_Step       = 0;
 	ADPCM_Playing    = 0;
-	ADPCM_SampleRate = (44100 * 12);
+	ADPCM_SampleRate = (Config.SampleRate * 12);
+	for (i = 0; i < ADPCM_SampleRate/100; i++)
+		ADPCM_Ratio[i] = (uint8_t)((i*FM_IPSCALE)/(ADPCM_SampleRate/100));
 	ADPCM_PreCounter = 0;
 	memset(Outs, 0, sizeof(Outs));
 	OutsIp[0]  = OutsIp[1]  = OutsIp[2]  = OutsIp[3]  = -1;
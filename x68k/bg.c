@@ -34,7 +34,7 @@ int32_t	BG_VLINE = 0;
 static uint8_t	BGCHR8[8*8*256];
 static uint8_t	BGCHR16[16*16*256];
 
-uint16_t	BG_LineBuf[1600];
+pixel_t		BG_LineBuf[1600];
 uint16_t	BG_PriBuf[1600];
 
 uint32_t	VLINEBG = 0;
@@ -62,7 +62,7 @@ int BG_StateAction(StateMem *sm, int load, int data_only)
 		SFARRAY(BGCHR8, (8 * 8 * 256)),
 		SFARRAY(BGCHR16, (16 * 16 * 256)),
 		SFARRAY16(BG_PriBuf, 1600),
-		SFARRAY16(BG_LineBuf, 1600),
+		SFARRAYPIX(BG_LineBuf, 1600),
 
 		SFVAR(BG_HAdjust),
 		SFVAR(BG_VLINE),
@@ -289,6 +289,8 @@ typedef struct SPRITECTRLTBL SPRITECTRLTBL_T;
 static INLINE void Sprite_DrawLineMcr(int pri)
 {
 	SPRITECTRLTBL_T *sct = (SPRITECTRLTBL_T *)Sprite_Regs;
+	const uint32_t hs = WinDraw_HShift;
+	const uint32_t step = 1 << hs, hmask = step - 1, hofs = 16 - (16 >> hs);
 	uint32_t y;
 	uint32_t t;
 	int n;
@@ -327,14 +329,15 @@ static INLINE void Sprite_DrawLineMcr(int pri)
 					d = 1;
 				}
 
-				for (i = 0; i < 16; i++, t++, p += d) {
-					pal = *p & 0xf;
+				for (i = t & hmask; i < 16; i += step) {
+					pal = p[i * d] & 0xf;
 					if (pal) {
+						uint32_t o = ((t + i) >> hs) + hofs;
 						pal |= (sctp->sprite_ctrl >> 4) & 0xf0;
-						if (BG_PriBuf[t] >= n * 8) {
-							BG_LineBuf[t] = TextPal[pal];
-							Text_TrFlag[t] |= 2;
-							BG_PriBuf[t] = n * 8;
+						if (BG_PriBuf[o] >= n * 8) {
+							BG_LineBuf[o] = TextPal[pal];
+							Text_TrFlag[o] |= 2;
+							BG_PriBuf[o] = n * 8;
 						}
 					}
 				}
@@ -343,31 +346,37 @@ static INLINE void Sprite_DrawLineMcr(int pri)
 	}
 }
 
+/* Source dots land at BG_LineBuf[((edi + 1 + j) >> hs) + hofs]; with a
+ * halved output width only the even ones are sampled. */
 #define BG_DRAWLINE_LOOPY(cnt) \
 { \
 	bl = bl << 4;							\
-	for (j = 0; j < cnt; j++, esi += d, edi++) {			\
-		dat = *esi | bl;					\
+	for (j = (edi + 1) & hmask; j < cnt; j += step) {		\
+		dat = esi[j * d] | bl;					\
 		if (dat == 0)						\
 			continue;					\
-		if ((dat & 0xf) || !(Text_TrFlag[edi + 1] & 2)) {	\
-			BG_LineBuf[1 + edi] = TextPal[dat];		\
-			Text_TrFlag[edi + 1] |= 2;			\
+		o = ((edi + 1 + j) >> hs) + hofs;			\
+		if ((dat & 0xf) || !(Text_TrFlag[o] & 2)) {		\
+			BG_LineBuf[o] = TextPal[dat];			\
+			Text_TrFlag[o] |= 2;				\
 		}							\
 	}								\
+	edi += cnt;							\
 }
 
 #define BG_DRAWLINE_LOOPY_NG(cnt) \
 {  \
 	bl = bl << 4;					    \
-        for (j = 0; j < cnt; j++, esi += d, edi++) {	    \
-                dat = *esi & 0xf;			    \
+        for (j = (edi + 1) & hmask; j < cnt; j += step) {   \
+                dat = esi[j * d] & 0xf;		    \
 		if (dat) {				    \
 			dat |= bl;			    \
-                        BG_LineBuf[1 + edi] = TextPal[dat]; \
-			Text_TrFlag[edi + 1] |= 2;	    \
+			o = ((edi + 1 + j) >> hs) + hofs;   \
+                        BG_LineBuf[o] = TextPal[dat];	    \
+			Text_TrFlag[o] |= 2;		    \
                 }					    \
         }						    \
+	edi += cnt;					    \
 }
 
 static void bg_drawline_loopx8(uint16_t BGTOP, uint32_t BGScrollX, uint32_t BGScrollY, int32_t adjust, int ng)
@@ -376,6 +385,9 @@ static void bg_drawline_loopx8(uint16_t BGTOP, uint32_t BGScrollX, uint32_t BGSc
        int i, j, d;
        uint16_t si;
        uint8_t *esi;
+       const uint32_t hs = WinDraw_HShift;
+       const uint32_t step = 1 << hs, hmask = step - 1, hofs = 16 - (16 >> hs);
+       uint32_t o;
        uint32_t ebp = ((BGScrollY + VLINEBG - BG_VLINE) & 7) << 3;
        uint32_t edx = BGTOP + (((BGScrollY + VLINEBG - BG_VLINE) & 0x1f8) << 4);
        uint32_t edi = ((BGScrollX - adjust) & 7) ^ 15;
@@ -414,6 +426,9 @@ static void bg_drawline_loopx16(uint16_t BGTOP, uint32_t BGScrollX, uint32_t BGS
        uint8_t dat, bl;
        int i, j, d;
        uint8_t *esi;
+       const uint32_t hs = WinDraw_HShift;
+       const uint32_t step = 1 << hs, hmask = step - 1, hofs = 16 - (16 >> hs);
+       uint32_t o;
        uint32_t ebp = ((BGScrollY + VLINEBG - BG_VLINE) & 15) << 4;
        uint32_t edx = BGTOP + (((BGScrollY + VLINEBG - BG_VLINE) & 0x3f0) << 3);
        uint32_t edi = ((BGScrollX - adjust) & 15) ^ 15;
@@ -475,7 +490,7 @@ void FASTCALL BG_DrawLine(int opaq, int gd)
 
 	if (opaq)
    {
-		for (i = 16; i < TextDotX + 16; ++i)
+		for (i = 16; i < WinDraw_DotX + 16; ++i)
       {
 			BG_LineBuf[i] = TextPal[0];
 			BG_PriBuf[i] = 0xffff;
@@ -483,7 +498,7 @@ void FASTCALL BG_DrawLine(int opaq, int gd)
 	}
    else
    {
-		for (i = 16; i < TextDotX + 16; ++i)
+		for (i = 16; i < WinDraw_DotX + 16; ++i)
 			BG_PriBuf[i] = 0xffff;
 	}
 
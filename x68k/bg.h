@@ -12,7 +12,7 @@ extern	int32_t	BG_VLINE;
 extern	uint32_t VLINEBG;
 
 extern	uint8_t	Sprite_DrawWork[1024*1024];
-extern	uint16_t BG_LineBuf[1600];
+extern	pixel_t BG_LineBuf[1600];
 
 void BG_Init(void);
 
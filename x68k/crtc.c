@@ -79,7 +79,8 @@ int CRTC_StateAction(StateMem *sm, int load, int data_only)
 
 	ret = PX68KSS_StateAction(sm, load, data_only, StateRegs, "X68K_CRTC_VCTRL", false);
 
-   if (load)
+   /* vidmode is only set when the section was there */
+   if (load && ret)
    {
       if (VID_MODE != vidmode)
       {
@@ -95,19 +96,9 @@ int CRTC_StateAction(StateMem *sm, int load, int data_only)
 void CRTC_RasterCopy(void)
 {
 	uint32_t line = (((uint32_t)CRTC_Regs[0x2d])<<2);
-	uint32_t src  = (((uint32_t)CRTC_Regs[0x2c])<<9);
-	uint32_t dst  = (((uint32_t)CRTC_Regs[0x2d])<<9);
+	int i;
 
-{
-	static const uint32_t off[4] = { 0, 0x20000, 0x40000, 0x60000 };
-	int i, bit;
-
-	for (bit = 0; bit < 4; bit++)
-   {
-		if (CRTC_Regs[0x2b] & (1 << bit))
-			memmove(&TVRAM[dst + off[bit]], &TVRAM[src + off[bit]],
-			    sizeof(uint32_t) * 128);
-	}
+	TVRAM_RasterCopy(CRTC_Regs[0x2c], CRTC_Regs[0x2d], CRTC_Regs[0x2b]);
 
 	line = (line - TextScrollY) & 0x3ff;
 	for (i = 0; i < 4; i++) {
@@ -116,9 +107,6 @@ void CRTC_RasterCopy(void)
 	}
 }
 
-	TVRAM_RCUpdate();
-}
-
 /*
  * $e82000 256.w -- Graphics Palette
  * $e82200 256.w -- Text Palette, Sprite + BG Palette
@@ -13,9 +13,11 @@
 #include	<string.h>
 
 uint8_t	GVRAM[0x80000];
-uint16_t	Grp_LineBuf[1024];
-uint16_t	Grp_LineBufSP[1024];		/* Special priority/semi-transparent buffer */
-uint16_t	Grp_LineBufSP2[1024];		/* Buffer for semi-transparent base plane (stores non-semi-transparent bits) */
+static uint8_t	GVRAM_Dirty[0x80000 >> PX68KSTATE_PAGE_SHIFT];
+static PX68KPages GVRAM_Pages = { GVRAM, GVRAM_Dirty, 0x80000, 0x80000, NULL, NULL, NULL };
+pixel_t		Grp_LineBuf[1024];
+pixel_t		Grp_LineBufSP[1024];		/* Special priority/semi-transparent buffer */
+pixel_t		Grp_LineBufSP2[1024];		/* Buffer for semi-transparent base plane (stores non-semi-transparent bits) */
 static uint16_t	Grp_LineBufSP_Tr[1024];
 static uint16_t	Pal16Adr[256];			/* Buffer for semi-transparent base plane (stores non-semi-transparent bits) */
 
@@ -23,10 +25,10 @@ int GVRAM_StateAction(StateMem *sm, int load, int data_only)
 {
 	SFORMAT StateRegs[] = 
 	{
-		SFARRAYN(GVRAM, 524288, "MEM_GVRAM"),
-		SFARRAY16(Grp_LineBuf, 1024),
-		SFARRAY16(Grp_LineBufSP, 1024),
-		SFARRAY16(Grp_LineBufSP2, 1024),
+		SFPAGESN(GVRAM_Pages, "MEM_GVRAM"),
+		SFARRAYPIX(Grp_LineBuf, 1024),
+		SFARRAYPIX(Grp_LineBufSP, 1024),
+		SFARRAYPIX(Grp_LineBufSP2, 1024),
 		SFARRAY16(Grp_LineBufSP_Tr, 1024),
 		SFARRAY16(Pal16Adr, 256),
 
@@ -49,6 +51,8 @@ void GVRAM_Init(void)
 	int i;
 
 	memset(GVRAM, 0, 0x80000);
+	memset(GVRAM_Dirty, 1, sizeof(GVRAM_Dirty));
+	PX68KSS_AddPages(&GVRAM_Pages);
 	for (i=0; i<128; i++) /* For 16bit color palette address calculation */
 	{
 		Pal16Adr[i*2] = i*4;
@@ -77,6 +81,7 @@ void FASTCALL GVRAM_FastClear(void)
 	for (y = 0; y < v; y++) {
 		offset = ((y + GrphScrollY[0]) & 0x1ff) << 10;
 		p = (uint16_t *)(GVRAM + offset + ((GrphScrollX[0] & 0x1ff) * 2));
+		GVRAM_Dirty[offset >> PX68KSTATE_PAGE_SHIFT] = 1;
 
 		for (x = 0; x < w[0]; x++) {
 			*p++ &= CRTC_FastClrMask;
@@ -379,19 +384,58 @@ void FASTCALL GVRAM_Write(uint32_t adr, uint8_t data)
 		break;
 	}
 
+	/* adr is now the GVRAM offset that was written, if any */
+	GVRAM_Dirty[(adr & 0x7ffff) >> PX68KSTATE_PAGE_SHIFT] = 1;
 	TextDirtyLine[line] = 1;
 }
 
 
+/*
+ * Returns non-zero when both raster lines fetch identical GVRAM rows on
+ * every graphic page.
+ */
+int FASTCALL Grp_LineMatch(uint32_t line0, uint32_t line1)
+{
+	uint32_t y0, y1;
+	int page;
+
+	if ((CRTC_Regs[0x29] & 0x1c) == 0x1c) {
+		line0 <<= 1;
+		line1 <<= 1;
+	}
+
+	if (VCReg0[1] & 4) {		/* 1024dot */
+		y0 = (GrphScrollY[0] + line0) & 0x3ff;
+		y1 = (GrphScrollY[0] + line1) & 0x3ff;
+		if ((y0 ^ y1) & 0x200)
+			return 0;
+		y0 &= 0x1ff;
+		y1 &= 0x1ff;
+		return (y0 == y1) || !memcmp(GVRAM + (y0 << 10), GVRAM + (y1 << 10), 0x400);
+	}
+
+	for (page = 0; page < 4; page++) {
+		y0 = (GrphScrollY[page] + line0) & 0x1ff;
+		y1 = (GrphScrollY[page] + line1) & 0x1ff;
+		if ((y0 != y1) && memcmp(GVRAM + (y0 << 10), GVRAM + (y1 << 10), 0x400))
+			return 0;
+	}
+	return 1;
+}
+
 /*
  *   From here on, the screen will be expanded line by line.
  */
 void Grp_DrawLine16(void)
 {
-	uint16_t *srcp, *destp;
+	const uint32_t dotx = WinDraw_DotX;
+	const uint32_t step = 1 << WinDraw_HShift;
+	uint16_t *srcp;
+	pixel_t *destp;
 	uint32_t x;
 	uint32_t i;
-	uint16_t v, v0;
+	pixel_t v;
+	uint16_t v0;
 	uint32_t y = GrphScrollY[0] + VLINE;
 	if ((CRTC_Regs[0x29] & 0x1c) == 0x1c)
 		y += VLINE;
@@ -399,15 +443,16 @@ void Grp_DrawLine16(void)
 
 	x = GrphScrollX[0] & 0x1ff;
 	srcp = (uint16_t *)(GVRAM + y + x * 2);
-	destp = (uint16_t *)Grp_LineBuf;
+	destp = Grp_LineBuf;
 
-	x = (x ^ 0x1ff) + 1;
+	x = ((x ^ 0x1ff) + step) >> WinDraw_HShift;
 
 	v = v0 = 0;
 	i = 0;
-	if (x < TextDotX) {
+	if (x < dotx) {
 		for (; i < x; ++i) {
-			v = *srcp++;
+			v = *srcp;
+			srcp += step;
 			if (v != 0) {
 				v0 = (v >> 8) & 0xff;
 				v &= 0x00ff;
@@ -421,8 +466,9 @@ void Grp_DrawLine16(void)
 		srcp -= 0x200;
 	}
 
-	for (; i < TextDotX; ++i) {
-		v = *srcp++;
+	for (; i < dotx; ++i) {
+		v = *srcp;
+		srcp += step;
 		if (v != 0) {
 			v0 = (v >> 8) & 0xff;
 			v &= 0x00ff;
@@ -437,12 +483,15 @@ void Grp_DrawLine16(void)
 
 void FASTCALL Grp_DrawLine8(int page, int opaq)
 {
-	uint16_t *srcp, *destp;
+	const uint32_t dotx = WinDraw_DotX;
+	const uint32_t step = 1 << WinDraw_HShift;
+	uint16_t *srcp;
+	pixel_t *destp;
 	uint32_t x, x0;
 	uint32_t y, y0;
 	uint32_t off;
 	uint32_t i;
-	uint16_t v;
+	pixel_t v;
 
 	page &= 1;
 
@@ -460,65 +509,65 @@ void FASTCALL Grp_DrawLine8(int page, int opaq)
 
 	off = y0 + x0 * 2;
 	srcp = (uint16_t *)(GVRAM + y + x * 2);
-	destp = (uint16_t *)Grp_LineBuf;
+	destp = Grp_LineBuf;
 
-	x = (x ^ 0x1ff) + 1;
+	x = ((x ^ 0x1ff) + step) >> WinDraw_HShift;
 
 	v = 0;
 	i = 0;
 
 	if (opaq) {
-		if (x < TextDotX) {
+		if (x < dotx) {
 			for (; i < x; ++i) {
 				v = GET_WORD_W8(srcp);
-				srcp++;
+				srcp += step;
 				v = GrphPal[(GVRAM[off] & 0xf0) | (v & 0x0f)];
 				*destp++ = v;
 
-				off += 2;
-				if ((off & 0x3fe) == 0x000)
+				off += step * 2;
+				if ((off & 0x3fe) < step * 2)
 					off -= 0x400;
 			}
 			srcp -= 0x200;
 		}
 
-		for (; i < TextDotX; ++i) {
+		for (; i < dotx; ++i) {
 			v = GET_WORD_W8(srcp);
-			srcp++;
+			srcp += step;
 			v = GrphPal[(GVRAM[off] & 0xf0) | (v & 0x0f)];
 			*destp++ = v;
 
-			off += 2;
-			if ((off & 0x3fe) == 0x000)
+			off += step * 2;
+			if ((off & 0x3fe) < step * 2)
 				off -= 0x400;
 		}
 	} else {
-		if (x < TextDotX) {
+		if (x < dotx) {
 			for (; i < x; ++i) {
 				v = GET_WORD_W8(srcp);
-				srcp++;
+				srcp += step;
 				v = (GVRAM[off] & 0xf0) | (v & 0x0f);
 				if (v != 0x00)
 					*destp = GrphPal[v];
 				destp++;
 
-				off += 2;
-				if ((off & 0x3fe) == 0x000)
+				off += step * 2;
+				if ((off & 0x3fe) < step * 2)
 					off -= 0x400;
 			}
 			srcp -= 0x200;
 		}
 
-		for (; i < TextDotX; ++i) {
+		for (; i < dotx; ++i) {
 			v = GET_WORD_W8(srcp);
-			srcp++;
+			srcp += step;
 			v = (GVRAM[off] & 0xf0) | (v & 0x0f);
 			if (v != 0x00)
 				*destp = GrphPal[v];
 			destp++;
 
-			off += 2;
-			if ((off & 0x3fe) == 0x000)
+			off += step * 2;
+			if ((off & 0x3fe) < step * 2)
 				off -= 0x400;
 		}
 	}
@@ -527,11 +576,14 @@ void FASTCALL Grp_DrawLine8(int page, int opaq)
 /* Manhattan Requiem Opening 7.0ｿｿ7.5MHz */
 void FASTCALL Grp_DrawLine4(uint32_t page, int opaq)
 {
-	uint16_t *srcp, *destp;	/* XXX: ALIGN */
+	const uint32_t dotx = WinDraw_DotX;
+	const uint32_t step = 1 << WinDraw_HShift;
+	uint16_t *srcp;	/* XXX: ALIGN */
+	pixel_t *destp;
 	uint32_t x, y;
 	uint32_t off;
 	uint32_t i;
-	uint16_t v;
+	pixel_t v;
 
 	page &= 3;
 
@@ -543,36 +595,36 @@ void FASTCALL Grp_DrawLine4(uint32_t page, int opaq)
 	x = GrphScrollX[page] & 0x1ff;
 	off = y + x * 2;
 
-	x ^= 0x1ff;
+	x = ((x ^ 0x1ff) + step - 1) >> WinDraw_HShift;
 
 	srcp = (uint16_t *)(GVRAM + off + (page >> 1));
-	destp = (uint16_t *)Grp_LineBuf;
+	destp = Grp_LineBuf;
 
 	v = 0;
 	i = 0;
 
 	if (page & 1) {
 		if (opaq) {
-			if (x < TextDotX) {
+			if (x < dotx) {
 				for (; i < x; ++i) {
 					v = GET_WORD_W8(srcp);
-					srcp++;
+					srcp += step;
 					v = GrphPal[(v >> 4) & 0xf];
 					*destp++ = v;
 				}
 				srcp -= 0x200;
 			}
-			for (; i < TextDotX; ++i) {
+			for (; i < dotx; ++i) {
 				v = GET_WORD_W8(srcp);
-				srcp++;
+				srcp += step;
 				v = GrphPal[(v >> 4) & 0xf];
 				*destp++ = v;
 			}
 		} else {
-			if (x < TextDotX) {
+			if (x < dotx) {
 				for (; i < x; ++i) {
 					v = GET_WORD_W8(srcp);
-					srcp++;
+					srcp += step;
 					v = (v >> 4) & 0x0f;
 					if (v != 0x00)
 						*destp = GrphPal[v];
@@ -580,9 +632,9 @@ void FASTCALL Grp_DrawLine4(uint32_t page, int opaq)
 				}
 				srcp -= 0x200;
 			}
-			for (; i < TextDotX; ++i) {
+			for (; i < dotx; ++i) {
 				v = GET_WORD_W8(srcp);
-				srcp++;
+				srcp += step;
 				v = (v >> 4) & 0x0f;
 				if (v != 0x00)
 					*destp = GrphPal[v];
@@ -591,26 +643,26 @@ void FASTCALL Grp_DrawLine4(uint32_t page, int opaq)
 		}
 	} else {
 		if (opaq) {
-			if (x < TextDotX) {
+			if (x < dotx) {
 				for (; i < x; ++i) {
 					v = GET_WORD_W8(srcp);
-					srcp++;
+					srcp += step;
 					v = GrphPal[v & 0x0f];
 					*destp++ = v;
 				}
 				srcp -= 0x200;
 			}
-			for (; i < TextDotX; ++i) {
+			for (; i < dotx; ++i) {
 				v = GET_WORD_W8(srcp);
-				srcp++;
+				srcp += step;
 				v = GrphPal[v & 0x0f];
 				*destp++ = v;
 			}
 		} else {
-			if (x < TextDotX) {
+			if (x < dotx) {
 				for (; i < x; ++i) {
 					v = GET_WORD_W8(srcp);
-					srcp++;
+					srcp += step;
 					v &= 0x0f;
 					if (v != 0x00)
 						*destp = GrphPal[v];
@@ -618,9 +670,9 @@ void FASTCALL Grp_DrawLine4(uint32_t page, int opaq)
 				}
 				srcp -= 0x200;
 			}
-			for (; i < TextDotX; ++i) {
+			for (; i < dotx; ++i) {
 				v = GET_WORD_W8(srcp);
-				srcp++;
+				srcp += step;
 				v &= 0x0f;
 				if (v != 0x00)
 					*destp = GrphPal[v];
@@ -632,7 +684,10 @@ void FASTCALL Grp_DrawLine4(uint32_t page, int opaq)
 
 void FASTCALL Grp_DrawLine4h(void)
 {
-	uint16_t *srcp, *destp;
+	const uint32_t dotx = WinDraw_DotX;
+	const uint32_t step = 1 << WinDraw_HShift;
+	uint16_t *srcp;
+	pixel_t *destp;
 	uint32_t x, y;
 	uint32_t i;
 	uint16_t v;
@@ -653,18 +708,19 @@ void FASTCALL Grp_DrawLine4h(void)
 
 	x = GrphScrollX[0] & 0x1ff;
 	srcp = (uint16_t *)(GVRAM + y + x * 2);
-	destp = (uint16_t *)Grp_LineBuf;
+	destp = Grp_LineBuf;
 
-	x = ((x & 0x1ff) ^ 0x1ff) + 1;
+	x = (((x & 0x1ff) ^ 0x1ff) + step) >> WinDraw_HShift;
 
-	for (i = 0; i < TextDotX; ++i) {
-		v = *srcp++;
+	for (i = 0; i < dotx; ++i) {
+		v = *srcp;
+		srcp += step;
 		*destp++ = GrphPal[(v >> bits) & 0x0f];
 
-		if (--x == 0) {
+		if (i + 1 == x) {
 			srcp -= 0x200;
 			bits ^= 4;
-			x = 512;
+			x += 512 >> WinDraw_HShift;
 		}
 	}
 }
@@ -675,6 +731,8 @@ void FASTCALL Grp_DrawLine4h(void)
  */
 void FASTCALL Grp_DrawLine16SP(void)
 {
+	const uint32_t dotx = WinDraw_DotX;
+	const uint32_t step = 1 << WinDraw_HShift;
 	uint32_t x, y;
 	uint32_t off;
 	uint32_t i;
@@ -687,9 +745,9 @@ void FASTCALL Grp_DrawLine16SP(void)
 
 	x = GrphScrollX[0] & 0x1ff;
 	off = y + x * 2;
-	x = (x ^ 0x1ff) + 1;
+	x = ((x ^ 0x1ff) + step) >> WinDraw_HShift;
 
-	for (i = 0; i < TextDotX; ++i) {
+	for (i = 0; i < dotx; ++i) {
 		v = (Pal_Regs[GVRAM[off+1]*2] << 8) | Pal_Regs[GVRAM[off]*2+1];
 		if ((GVRAM[off] & 1) == 0) {
 			Grp_LineBufSP[i] = 0;
@@ -699,8 +757,8 @@ void FASTCALL Grp_DrawLine16SP(void)
 			Grp_LineBufSP2[i] = 0;
 		}
 
-		off += 2;
-		if (--x == 0)
+		off += step * 2;
+		if (i + 1 == x)
 			off -= 0x400;
 	}
 }
@@ -708,11 +766,13 @@ void FASTCALL Grp_DrawLine16SP(void)
 
 void FASTCALL Grp_DrawLine8SP(int page)
 {
+	const uint32_t dotx = WinDraw_DotX;
+	const uint32_t step = 1 << WinDraw_HShift;
 	uint32_t x, x0;
 	uint32_t y, y0;
 	uint32_t off, off0;
 	uint32_t i;
-	uint16_t v;
+	pixel_t v;
 
 	page &= 1;
 
@@ -731,9 +791,9 @@ void FASTCALL Grp_DrawLine8SP(int page)
 	off = y + x * 2 + page;
 	off0 = y0 + x0 * 2 + page;
 
-	x = (x ^ 0x1ff) + 1;
+	x = ((x ^ 0x1ff) + step) >> WinDraw_HShift;
 
-	for (i = 0; i < TextDotX; ++i) {
+	for (i = 0; i < dotx; ++i) {
 		v = (GVRAM[off] & 0x0f) | (GVRAM[off0] & 0xf0);
 		Grp_LineBufSP_Tr[i] = 0;
 
@@ -755,17 +815,19 @@ void FASTCALL Grp_DrawLine8SP(int page)
 			Grp_LineBufSP2[i] = 0;
 		}
 
-		off += 2;
-		off0 += 2;
-		if ((off0 & 0x3fe) == 0)
+		off += step * 2;
+		off0 += step * 2;
+		if ((off0 & 0x3fe) < step * 2)
 			off0 -= 0x400;
-		if (--x == 0)
+		if (i + 1 == x)
 			off -= 0x400;
 	}
 }
 
 void FASTCALL Grp_DrawLine4SP(uint32_t page/*, int opaq*/)
 {
+	const uint32_t dotx = WinDraw_DotX;
+	const uint32_t step = 1 << WinDraw_HShift;
 	uint32_t x, y;
 	uint32_t off;
 	uint32_t i;
@@ -803,9 +865,9 @@ void FASTCALL Grp_DrawLine4SP(uint32_t page/*, int opaq*/)
       off = y + x * 2;
       if (page & 2)
          off++;
-      x = (x ^ 0x1ff) + 1;
+      x = ((x ^ 0x1ff) + step) >> WinDraw_HShift;
 
-      for (i = 0; i < TextDotX; ++i) {
+      for (i = 0; i < dotx; ++i) {
          v = GVRAM[off] >> 4;
          if ((v & 1) == 0) {
             v &= 0x0e;
@@ -817,8 +879,8 @@ void FASTCALL Grp_DrawLine4SP(uint32_t page/*, int opaq*/)
             Grp_LineBufSP2[i] = 0;
          }
 
-         off += 2;
-         if (--x == 0)
+         off += step * 2;
+         if (i + 1 == x)
             off -= 0x400;
       }
    }
@@ -833,9 +895,9 @@ void FASTCALL Grp_DrawLine4SP(uint32_t page/*, int opaq*/)
       off = y + x * 2;
       if (page & 2)
          off++;
-      x = (x ^ 0x1ff) + 1;
+      x = ((x ^ 0x1ff) + step) >> WinDraw_HShift;
 
-      for (i = 0; i < TextDotX; ++i) {
+      for (i = 0; i < dotx; ++i) {
          v = GVRAM[off];
          if ((v & 1) == 0) {
             v &= 0x0e;
@@ -847,8 +909,8 @@ void FASTCALL Grp_DrawLine4SP(uint32_t page/*, int opaq*/)
             Grp_LineBufSP2[i] = 0;
          }
 
-         off += 2;
-         if (--x == 0)
+         off += step * 2;
+         if (i + 1 == x)
             off -= 0x400;
       }
    }
@@ -857,6 +919,8 @@ void FASTCALL Grp_DrawLine4SP(uint32_t page/*, int opaq*/)
 
 void FASTCALL Grp_DrawLine4hSP(void)
 {
+	const uint32_t dotx = WinDraw_DotX;
+	const uint32_t step = 1 << WinDraw_HShift;
 	uint16_t *srcp;
 	uint32_t x;
 	uint32_t i;
@@ -880,11 +944,12 @@ void FASTCALL Grp_DrawLine4hSP(void)
 
 	x    = GrphScrollX[0] & 0x1ff;
 	srcp = (uint16_t *)(GVRAM + y + x * 2);
-	x    = ((x & 0x1ff) ^ 0x1ff) + 1;
+	x    = (((x & 0x1ff) ^ 0x1ff) + step) >> WinDraw_HShift;
 
-	for (i = 0; i < TextDotX; ++i)
+	for (i = 0; i < dotx; ++i)
    {
-      v = *srcp++ >> bits;
+      v = *srcp >> bits;
+      srcp += step;
       if ((v & 1) == 0)
       {
          Grp_LineBufSP[i]  = 0;
@@ -896,13 +961,21 @@ void FASTCALL Grp_DrawLine4hSP(void)
          Grp_LineBufSP2[i] = 0;
       }
 
-      if (--x == 0)
-         srcp -= 0x400;
+      /* past the 512 words of the row: back to its start, in the
+       * other half of the plane, as Grp_DrawLine4h() does */
+      if (i + 1 == x)
+      {
+         srcp -= 0x200;
+         bits ^= 4;
+         x    += 512 >> WinDraw_HShift;
+      }
    }
 }
 
 void FASTCALL Grp_DrawLine8TR(int page, int opaq)
 {
+	const uint32_t dotx = WinDraw_DotX;
+	const uint32_t step = 1 << WinDraw_HShift;
 	if (opaq)
    {
       uint32_t x, y;
@@ -917,7 +990,7 @@ void FASTCALL Grp_DrawLine8TR(int page, int opaq)
       y = ((y & 0x1ff) << 10) + page;
       x = GrphScrollX[page * 2] & 0x1ff;
 
-      for (i = 0; i < TextDotX; ++i, x = (x + 1) & 0x1ff) {
+      for (i = 0; i < dotx; ++i, x = (x + step) & 0x1ff) {
          v0 = Grp_LineBufSP[i];
          v = GVRAM[y + x * 2];
 
@@ -935,13 +1008,15 @@ void FASTCALL Grp_DrawLine8TR(int page, int opaq)
             }
          } else
             v = GrphPal[v];
-         Grp_LineBuf[i] = (uint16_t)v;
+         Grp_LineBuf[i] = (pixel_t)v;
       }
    }
 }
 
 void FASTCALL Grp_DrawLine8TR_GT(int page, int opaq)
 {
+	const uint32_t dotx = WinDraw_DotX;
+	const uint32_t step = 1 << WinDraw_HShift;
 	if (opaq)
    {
       uint32_t x, y;
@@ -955,7 +1030,7 @@ void FASTCALL Grp_DrawLine8TR_GT(int page, int opaq)
       y = ((y & 0x1ff) << 10) + page;
       x = GrphScrollX[page * 2] & 0x1ff;
 
-      for (i = 0; i < TextDotX; ++i, x = (x + 1) & 0x1ff)
+      for (i = 0; i < dotx; ++i, x = (x + step) & 0x1ff)
       {
          Grp_LineBuf[i]      = (Grp_LineBufSP[i] || Grp_LineBufSP_Tr[i]) ? 0 : GrphPal[GVRAM[y + x * 2]];
          Grp_LineBufSP_Tr[i] = 0;
@@ -965,6 +1040,8 @@ void FASTCALL Grp_DrawLine8TR_GT(int page, int opaq)
 
 void FASTCALL Grp_DrawLine4TR(uint32_t page, int opaq)
 {
+   const uint32_t dotx = WinDraw_DotX;
+   const uint32_t step = 1 << WinDraw_HShift;
    uint32_t x, y;
    uint32_t v, v0;
    uint32_t i;
@@ -982,7 +1059,7 @@ void FASTCALL Grp_DrawLine4TR(uint32_t page, int opaq)
       y += page;
 
       if (opaq) {
-         for (i = 0; i < TextDotX; ++i, x = (x + 1) & 0x1ff) {
+         for (i = 0; i < dotx; ++i, x = (x + step) & 0x1ff) {
             v0 = Grp_LineBufSP[i];
             v = GVRAM[y + x * 2] >> 4;
 
@@ -1000,10 +1077,10 @@ void FASTCALL Grp_DrawLine4TR(uint32_t page, int opaq)
                }
             } else
                v = GrphPal[v];
-            Grp_LineBuf[i] = (uint16_t)v;
+            Grp_LineBuf[i] = (pixel_t)v;
          }
       } else {
-         for (i = 0; i < TextDotX; ++i, x = (x + 1) & 0x1ff) {
+         for (i = 0; i < dotx; ++i, x = (x + step) & 0x1ff) {
             v0 = Grp_LineBufSP[i];
 
             if (v0 == 0)
@@ -1025,11 +1102,11 @@ void FASTCALL Grp_DrawLine4TR(uint32_t page, int opaq)
                         v0 |= Pal_Ix2;
                      v &= Pal_HalfMask;
                      v += v0;
-                     v = GrphPal[v >> 1];
-                     Grp_LineBuf[i]=(uint16_t)v;
+                     v >>= 1;
+                     Grp_LineBuf[i]=(pixel_t)v;
                   }
                } else
-                  Grp_LineBuf[i] = (uint16_t)v;
+                  Grp_LineBuf[i] = (pixel_t)v;
             }
          }
       }
@@ -1039,7 +1116,7 @@ void FASTCALL Grp_DrawLine4TR(uint32_t page, int opaq)
 
       if (opaq)
       {
-         for (i = 0; i < TextDotX; ++i, x = (x + 1) & 0x1ff)
+         for (i = 0; i < dotx; ++i, x = (x + step) & 0x1ff)
          {
             v  = GVRAM[y + x * 2] & 0x0f;
             v0 = Grp_LineBufSP[i];
@@ -1061,12 +1138,12 @@ void FASTCALL Grp_DrawLine4TR(uint32_t page, int opaq)
                }
             } else
                v = GrphPal[v];
-            Grp_LineBuf[i] = (uint16_t)v;
+            Grp_LineBuf[i] = (pixel_t)v;
          }
       }
       else
       {
-         for (i = 0; i < TextDotX; ++i, x = (x + 1) & 0x1ff)
+         for (i = 0; i < dotx; ++i, x = (x + step) & 0x1ff)
          {
             v  = GVRAM[y + x * 2] & 0x0f;
             v0 = Grp_LineBufSP[i];
@@ -1084,10 +1161,10 @@ void FASTCALL Grp_DrawLine4TR(uint32_t page, int opaq)
                      v &= Pal_HalfMask;
                      v += v0;
                      v >>= 1;
-                     Grp_LineBuf[i]=(uint16_t)v;
+                     Grp_LineBuf[i]=(pixel_t)v;
                   }
                } else
-                  Grp_LineBuf[i] = (uint16_t)v;
+                  Grp_LineBuf[i] = (pixel_t)v;
             } else if (v != 0)
                Grp_LineBuf[i] = GrphPal[v];
          }
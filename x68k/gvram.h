@@ -5,9 +5,9 @@
 #include "common.h"
 
 extern	uint8_t	GVRAM[0x80000];
-extern	uint16_t	Grp_LineBuf[1024];
-extern	uint16_t	Grp_LineBufSP[1024];
-extern	uint16_t	Grp_LineBufSP2[1024];
+extern	pixel_t		Grp_LineBuf[1024];
+extern	pixel_t		Grp_LineBufSP[1024];
+extern	pixel_t		Grp_LineBufSP2[1024];
 
 void GVRAM_Init(void);
 
@@ -27,6 +27,7 @@ void FASTCALL Grp_DrawLine4hSP(void);
 void FASTCALL Grp_DrawLine8TR(int page, int opaq);
 void FASTCALL Grp_DrawLine8TR_GT(int page, int opaq);
 void FASTCALL Grp_DrawLine4TR(uint32_t page, int opaq);
+int FASTCALL Grp_LineMatch(uint32_t line0, uint32_t line1);
 int GVRAM_StateAction(StateMem *sm, int load, int data_only);
 
 #endif /* _WINX68K_GVRAM_H */
@@ -28,6 +28,8 @@
 
 uint8_t *IPL;
 uint8_t *MEM;
+static uint8_t MEM_Dirty[0xc00000 >> PX68KSTATE_PAGE_SHIFT];
+PX68KPages MEM_Pages = { NULL, MEM_Dirty, 0xc00000, 0xc00000, NULL, NULL, NULL };
 static uint8_t *OP_ROM;
 uint8_t *FONT;
 
@@ -142,6 +144,7 @@ static void wm_cnt(uint32_t addr, uint8_t val)
 #else
 		MEM[addr ^ 1] = val;
 #endif
+		MEM_Dirty[addr >> PX68KSTATE_PAGE_SHIFT] = 1;
 	}
 	else if (addr < 0x00e00000)
 		GVRAM_Write(addr, val);
@@ -216,7 +219,10 @@ static void cpu_setOPbase24(uint32_t addr)
 
       case 0xe:
          if (addr < 0x00e80000) 
+         {
+            TVRAM_RCFlush();
             OP_ROM = TVRAM + (addr - 0x00e00000);
+         }
          else if ((addr >= 0x00ea0000) && (addr < 0x00ea2000))
             OP_ROM = SCSIIPL + (addr - 0x00ea0000);
          else if ((addr >= 0x00ed0000) && (addr < 0x00ed4000))
@@ -406,6 +412,13 @@ cpu_readmem24_dword(uint32_t addr)
  */
 void Memory_Init(void)
 {
+	if (MEM_Pages.mem != MEM)
+	{
+		MEM_Pages.mem = MEM;
+		memset(MEM_Dirty, 1, sizeof(MEM_Dirty));
+	}
+	PX68KSS_AddPages(&MEM_Pages);
+
 #if defined (HAVE_CYCLONE)
 	cpu_setOPbase24((uint32_t)m68000_get_reg(M68K_PC));
 #elif defined (HAVE_C68K)
@@ -1,4 +1,5 @@
 #include "common.h"
+#include "prop.h"
 #include "dswin.h"
 #include "fmg_wrap.h"
 #include "dmac.h"
@@ -9,6 +10,7 @@
 
 #define MCRY_IRQ 4
 #define Mcry_BufSize		48000*2
+#define Mcry_MixChunk		1024
 
 static int32_t	Mcry_WrPtr         = 0;
 static int32_t	Mcry_RdPtr         = 0;
@@ -21,6 +23,7 @@ static int16_t	Mcry_OutDataL   = 0;
 static int16_t	Mcry_OutDataR   = 0;
 static int16_t	Mcry_BufL[Mcry_BufSize];
 static int16_t	Mcry_BufR[Mcry_BufSize];
+static int16_t	Mcry_MixBuf[Mcry_MixChunk*2];
 static int32_t	Mcry_PreCounter    = 0;
 
 static int16_t	Mcry_OldR, Mcry_OldL;
@@ -28,6 +31,9 @@ static int	Mcry_DMABytes      = 0;
 static double Mcry_VolumeShift = 65536;
 static int Mcry_SampleCnt      = 0;
 static uint8_t Mcry_Vector     = 255;
+/* Set once the program accesses the unit; until then it is neither
+ * clocked nor mixed */
+static uint8_t Mcry_Active     = 0;
 
 extern uint32_t BusErrFlag;
 
@@ -52,6 +58,9 @@ int Mcry_IsReady(void)
 /* Store data in the buffer for the amount of MPU clock time elapsed */
 void FASTCALL Mcry_PreUpdate(uint32_t clock)
 {
+	if (!Mcry_Active)
+		return;
+
 	Mcry_PreCounter += (Mcry_ClockRate*clock);
 	while(Mcry_PreCounter>=10000000L)
 	{
@@ -62,41 +71,39 @@ void FASTCALL Mcry_PreUpdate(uint32_t clock)
 }
 
 /* Fill the buffer as requested by DSound */
-void FASTCALL Mcry_Update(int16_t *buffer, size_t length)
+void FASTCALL Mcry_Update(int32_t *buffer, size_t length)
 {
-	int data;
+	size_t i, n;
 
-	if (!length) return;
+	if (!Mcry_Active) return;
 
-	M288_Update(buffer, length);
 	while (length)
 	{
-		if ( Mcry_WrPtr==Mcry_RdPtr ) {
-			Mcry_SampleCnt = 1;
-			DMA_Exec(2); DMA_Exec(2);
-		}
+		/* the YMF288s saturate internally, so they get a 16-bit block
+		 * of their own that is added to the mix with the PCM */
+		n = (length < Mcry_MixChunk) ? length : Mcry_MixChunk;
+		memset(Mcry_MixBuf, 0, n * 2 * sizeof(int16_t));
+		M288_Update(Mcry_MixBuf, n);
 
-		if (Mcry_WrPtr!=Mcry_RdPtr)
+		for (i = 0; i < n; i++)
 		{
-			Mcry_OldL = Mcry_BufL[Mcry_RdPtr];
-			Mcry_OldR = Mcry_BufR[Mcry_RdPtr];
-			Mcry_RdPtr++;
-			if (Mcry_RdPtr>=Mcry_BufSize) Mcry_RdPtr=0;
-		}
-
-		data = *buffer;
-		data += Mcry_OldL;
-		if (data>32767) data = 32767;
-		else if (data<(-32768)) data = -32768;
-		*(buffer++) = (int16_t)data;
+			if ( Mcry_WrPtr==Mcry_RdPtr ) {
+				Mcry_SampleCnt = 1;
+				DMA_Exec(2); DMA_Exec(2);
+			}
 
-		data = *buffer;
-		data += Mcry_OldR;
-		if (data>32767) data = 32767;
-		else if (data<(-32768)) data = -32768;
-		*(buffer++) = (int16_t)data;
+			if (Mcry_WrPtr!=Mcry_RdPtr)
+			{
+				Mcry_OldL = Mcry_BufL[Mcry_RdPtr];
+				Mcry_OldR = Mcry_BufR[Mcry_RdPtr];
+				Mcry_RdPtr++;
+				if (Mcry_RdPtr>=Mcry_BufSize) Mcry_RdPtr=0;
+			}
 
-		length--;
+			*(buffer++) += Mcry_MixBuf[i*2] + Mcry_OldL;
+			*(buffer++) += Mcry_MixBuf[i*2+1] + Mcry_OldR;
+		}
+		length -= n;
 	}
 }
 
@@ -117,6 +124,7 @@ static INLINE void Mcry_WriteOne(void)
 
 void FASTCALL Mcry_Write(uint32_t adr, uint8_t data)
 {
+	Mcry_Active = 1;
 	if ((adr == 0xecc080)||(adr == 0xecc081)||(adr == 0xecc000)||(adr == 0xecc001))	/* Data Port */
 	{
 		if ( Mcry_SampleCnt<=0 ) return;
@@ -181,6 +189,7 @@ void FASTCALL Mcry_Write(uint32_t adr, uint8_t data)
 uint8_t FASTCALL Mcry_Read(uint32_t adr)
 {
 	uint8_t ret = 0;
+	Mcry_Active = 1;
 	if ((adr == 0xecc080)||(adr == 0xecc081)||(adr == 0xecc000)||(adr == 0xecc001)) { }
 	else if ((adr == 0xecc0a1)||(adr == 0xecc021))	/* Status Port */
 		ret = ((Mcry_Status&0xf0)|0x0f);
@@ -238,9 +247,10 @@ void Mcry_Init(const char* path)
 	Mcry_OutDataL = 0;
 	Mcry_OutDataR = 0;
 	Mcry_Status = 0;
-	Mcry_SampleRate = (int32_t)44100;
+	Mcry_SampleRate = (int32_t)Config.SampleRate;
 	Mcry_LRTiming = 0;
 	Mcry_PreCounter = 0;
+	Mcry_Active = 0;
 
 	Mcry_SetClock();
 
@@ -5,7 +5,7 @@
 
 extern uint8_t Mcry_LRTiming;
 
-void FASTCALL Mcry_Update(int16_t *buffer, size_t length);
+void FASTCALL Mcry_Update(int32_t *buffer, size_t length);
 void FASTCALL Mcry_PreUpdate(uint32_t clock);
 
 void FASTCALL Mcry_Write(uint32_t adr, uint8_t data);
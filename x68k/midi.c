@@ -16,6 +16,7 @@
 #define MIDIBUFTIMER 3200			/* 10MHz / (31.25K / 10bit) = 3200 */
 #define MIDIFIFOSIZE 256
 #define MIDIDELAYBUF 4096			/* is it ok to have 31250/10 = 3125 byts (1sec)?  */
+#define MIDICLOCKUS  10			/* MIDI_Timer() clocks per microsecond */
 
 enum {
 	MIDI_NOTUSED,
@@ -68,6 +69,12 @@ static DELAYBUFITEM DelayBuf[MIDIDELAYBUF];
 static int DBufPtrW = 0;
 static int DBufPtrR = 0;
 
+/* Emulated time: the bytes written are stamped with MIDI_Clock and sent
+ * at the end of the frame, spaced by the emulated time between them */
+static uint32_t		MIDI_Clock = 0;
+static uint32_t		MIDI_OutClock = 0;	/* stamp of the last message sent */
+static uint32_t		MIDI_MsgClock = 0;	/* stamp of the byte being parsed */
+
 /* Nekomichi 6, MIMPI tone map compatibility */
 
 enum {
@@ -139,6 +146,8 @@ int MIDI_StateAction(StateMem *sm, int load, int data_only)
 		SFARRAY(DelayBuf, ((4 + 1) * MIDIDELAYBUF)),
 		SFVAR(DBufPtrW),
 		SFVAR(DBufPtrR),
+		SFVAR(MIDI_Clock),
+		SFVAR(MIDI_OutClock),
 
 		SFEND
 	};
@@ -161,6 +170,7 @@ void FASTCALL MIDI_Timer(uint32_t clk)
 {
 	if ( !Config.MIDI_SW ) return;	/* return when MIDI is OFF */
 
+	MIDI_Clock += clk;
 	MIDI_BufTimer -= clk;
 	if (MIDI_BufTimer<0)
 	{
@@ -216,10 +226,18 @@ static void MIDI_SetModule(void)
 		MIDI_MODULE = MIDI_NOTUSED;
 }
 
-static void MIDI_Sendexclusive(uint8_t *excv, size_t length)
+/* Microseconds since the previous message, for the one being sent */
+static uint32_t MIDI_Delta(void)
+{
+	uint32_t delta = (MIDI_MsgClock - MIDI_OutClock) / MIDICLOCKUS;
+	MIDI_OutClock += delta * MIDICLOCKUS;
+	return delta;
+}
+
+static void MIDI_Sendexclusive(uint8_t *excv, size_t length, uint32_t delta)
 {
 	memcpy(MIDI_EXCVBUF, excv, length);
-	midi_out_long_msg(MIDI_EXCVBUF, length);
+	midi_out_long_msg(MIDI_EXCVBUF, length, delta);
 }
 
 void MIDI_Reset(void)
@@ -238,22 +256,22 @@ void MIDI_Reset(void)
 			case MIDI_CM32L:
 			case MIDI_CM64:
 			case MIDI_LA:
-				MIDI_Sendexclusive(EXCV_MTRESET, sizeof(EXCV_MTRESET));
+				MIDI_Sendexclusive(EXCV_MTRESET, sizeof(EXCV_MTRESET), 0);
 				break;
 			case MIDI_SC55:
 			case MIDI_SC88:
 			case MIDI_GS:
-				MIDI_Sendexclusive(EXCV_GSRESET, sizeof(EXCV_GSRESET));
+				MIDI_Sendexclusive(EXCV_GSRESET, sizeof(EXCV_GSRESET), 0);
 				break;
 			case MIDI_XG:
-				MIDI_Sendexclusive(EXCV_XGRESET, sizeof(EXCV_XGRESET));
+				MIDI_Sendexclusive(EXCV_XGRESET, sizeof(EXCV_XGRESET), 0);
 				break;
 			default:
-				MIDI_Sendexclusive(EXCV_GMRESET, sizeof(EXCV_GMRESET));
+				MIDI_Sendexclusive(EXCV_GMRESET, sizeof(EXCV_GMRESET), 0);
 				break;
 		}
 		for (msg=0x7bb0; msg<0x7bc0; msg++)
-			midi_out_short_msg(msg);
+			midi_out_short_msg(msg, 0);
 	}
 }
 
@@ -430,7 +448,7 @@ void MIDI_Message(uint8_t mes)
 						(TONE_CH[MIDI_BUF[0] & 0x0f] < MIMPI_RHYTHM))
 						MIDI_BUF[1] = TONEMAP[ TONE_CH[MIDI_BUF[0] & 0x0f] ][ MIDI_BUF[1] & 0x7f ];
 				}
-				midi_out_short_msg(MIDIOUTS(MIDI_BUF[0], MIDI_BUF[1], 0));
+				midi_out_short_msg(MIDIOUTS(MIDI_BUF[0], MIDI_BUF[1], 0), MIDI_Delta());
 				MIDI_CTRL = MIDICTRL_READY;
 			}
 			break;
@@ -439,14 +457,14 @@ void MIDI_Message(uint8_t mes)
 			{
 				midi_out_short_msg( 
 				MIDIOUTS(MIDI_BUF[0],
-					MIDI_BUF[1], MIDI_BUF[2]));
+					MIDI_BUF[1], MIDI_BUF[2]), MIDI_Delta());
 				MIDI_CTRL = MIDICTRL_READY;
 			}
 			break;
 		case MIDICTRL_EXCLUSIVE:
 			if (mes == MIDI_EOX)
 			{
-				MIDI_Sendexclusive(MIDI_BUF, MIDI_POS);
+				MIDI_Sendexclusive(MIDI_BUF, MIDI_POS, MIDI_Delta());
 				MIDI_CTRL = MIDICTRL_READY;
 			}
 			else if (MIDI_POS >= MIDIBUFFERS) /* overflow */
@@ -511,25 +529,23 @@ static void AddDelayBuf(uint8_t msg)
 	int newptr = (DBufPtrW+1)%MIDIDELAYBUF;
 	if ( newptr!=DBufPtrR )
 	{
-		DelayBuf[DBufPtrW].time = timeGetTime();
+		DelayBuf[DBufPtrW].time = MIDI_Clock;
 		DelayBuf[DBufPtrW].msg  = msg;
 		DBufPtrW = newptr;
 	}
 }
 
-void MIDI_DelayOut(unsigned int delay)
+/* Sends everything written during the frame; the first message is
+ * timed from the end of the previous frame */
+void MIDI_DelayOut(void)
 {
 	while ( DBufPtrW!=DBufPtrR )
 	{
-		unsigned int t = timeGetTime();
-		if ( (t-DelayBuf[DBufPtrR].time)>=delay )
-		{
-			MIDI_Message(DelayBuf[DBufPtrR].msg);
-			DBufPtrR = (DBufPtrR+1)%MIDIDELAYBUF;
-		}
-		else
-			break;
+		MIDI_MsgClock = DelayBuf[DBufPtrR].time;
+		MIDI_Message(DelayBuf[DBufPtrR].msg);
+		DBufPtrR = (DBufPtrR+1)%MIDIDELAYBUF;
 	}
+	MIDI_OutClock = MIDI_Clock;
 }
 
 void FASTCALL MIDI_Write(uint32_t adr, uint8_t data)
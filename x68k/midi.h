@@ -12,7 +12,7 @@ void FASTCALL MIDI_Write(uint32_t adr, uint8_t data);
 void FASTCALL MIDI_Timer(uint32_t clk);
 int MIDI_SetMimpiMap(char *filename);
 int MIDI_EnableMimpiDef(int enable);
-void MIDI_DelayOut(unsigned int delay);
+void MIDI_DelayOut(void);
 int MIDI_StateAction(StateMem *sm, int load, int data_only);
 
 #endif /* _WINX68K_MIDI_H */
@@ -12,22 +12,28 @@
 #include	"palette.h"
 
 uint8_t		Pal_Regs[1024];
-uint16_t	TextPal[256];
-uint16_t	GrphPal[256];
-uint16_t	Pal16[65536];
-uint16_t	Ibit;
+pixel_t		TextPal[256];
+pixel_t		GrphPal[256];
+pixel_t		Pal16[65536];
+pixel_t		Ibit;
 
-uint16_t	Pal_HalfMask, Pal_Ix2;
-uint16_t	Pal_R, Pal_G, Pal_B;
+pixel_t		Pal_HalfMask, Pal_Ix2;
+pixel_t		Pal_R, Pal_G, Pal_B;
+/* Channel bits below the top five, filled by replicating the high bits */
+static pixel_t	Pal_FillR, Pal_FillG, Pal_FillB;
+
+#define PAL_TOPBIT ((pixel_t)1 << (sizeof(pixel_t) * 8 - 1))
+#define PAL_LSB(x) ((x) & (~(x) + 1))
+#define PAL_FILL(c) ((((c) & Pal_R) >> 5) & Pal_FillR) | ((((c) & Pal_G) >> 5) & Pal_FillG) | ((((c) & Pal_B) >> 5) & Pal_FillB)
 
 int Pal_StateAction(StateMem *sm, int load, int data_only)
 {
 	SFORMAT StateRegs[] =
 	{
 		SFARRAY(Pal_Regs, 1024),
-		SFARRAY16(TextPal, 256),
-		SFARRAY16(GrphPal, 256),
-		SFARRAY16(Pal16, 65536),
+		SFARRAYPIX(TextPal, 256),
+		SFARRAYPIX(GrphPal, 256),
+		SFARRAYPIX(Pal16, 65536),
 
 		SFEND
 	};
@@ -40,16 +46,17 @@ int Pal_StateAction(StateMem *sm, int load, int data_only)
 void Pal_SetColor(void)
 {
 	int i;
-	uint16_t bit;
-	uint16_t R[5]     = {0, 0, 0, 0, 0};
-	uint16_t G[5]     = {0, 0, 0, 0, 0};
-	uint16_t B[5]     = {0, 0, 0, 0, 0};
+	pixel_t bit;
+	pixel_t R[5]     = {0, 0, 0, 0, 0};
+	pixel_t G[5]     = {0, 0, 0, 0, 0};
+	pixel_t B[5]     = {0, 0, 0, 0, 0};
 	int r         = 5;
 	int g         = 5;
 	int b         = 5;
 	Pal_R         = Pal_G = Pal_B = 0;
-	uint16_t TempMask = 0;
-	for (bit=0x8000; bit; bit>>=1)
+	pixel_t TempMask = 0;
+	pixel_t ChMask = WinDraw_Pal16R | WinDraw_Pal16G | WinDraw_Pal16B;
+	for (bit=PAL_TOPBIT; bit; bit>>=1)
 	{
 		if ( (WinDraw_Pal16R&bit)&&(r) )
 		{
@@ -71,6 +78,10 @@ void Pal_SetColor(void)
 		}
 	}
 
+	/* The intensity bit goes to a bit outside every channel when the host
+	 * format has one (XRGB8888), otherwise to the lowest unused one */
+	if ((pixel_t)~ChMask)
+		TempMask = ChMask;
 	Ibit = 1;
 	for (bit=1; bit; bit<<=1)
 	{
@@ -81,7 +92,11 @@ void Pal_SetColor(void)
 		}
 	}
 
-	Pal_HalfMask = ~(B[0] | R[0] | G[0] | Ibit);
+	Pal_FillR = WinDraw_Pal16R & ~Pal_R & ~Ibit;
+	Pal_FillG = WinDraw_Pal16G & ~Pal_G & ~Ibit;
+	Pal_FillB = WinDraw_Pal16B & ~Pal_B & ~Ibit;
+
+	Pal_HalfMask = ~(PAL_LSB(WinDraw_Pal16B & ~Ibit) | PAL_LSB(WinDraw_Pal16R & ~Ibit) | PAL_LSB(WinDraw_Pal16G & ~Ibit) | Ibit);
 	Pal_Ix2 = Ibit << 1;
 
 	for (i=0; i<65536; i++)
@@ -102,6 +117,7 @@ void Pal_SetColor(void)
 		if (i&0x0008) bit |= B[2];
 		if (i&0x0004) bit |= B[1];
 		if (i&0x0002) bit |= B[0];
+		bit |= PAL_FILL(bit);
 		if (i&0x0001) bit |= Ibit;
 		Pal16[i] = bit;
 	}
@@ -151,19 +167,19 @@ void FASTCALL Pal_Write(uint32_t adr, uint8_t data)
 
 void Pal_ChangeContrast(int num)
 {
-	uint16_t bit;
-	uint16_t R[5] = {0, 0, 0, 0, 0};
-	uint16_t G[5] = {0, 0, 0, 0, 0};
-	uint16_t B[5] = {0, 0, 0, 0, 0};
+	pixel_t bit;
+	pixel_t R[5] = {0, 0, 0, 0, 0};
+	pixel_t G[5] = {0, 0, 0, 0, 0};
+	pixel_t B[5] = {0, 0, 0, 0, 0};
 	int r, g, b, i;
-	int palr, palg, palb;
-	uint16_t pal;
+	uint32_t palr, palg, palb;
+	uint32_t pal;
 
 	TVRAM_SetAllDirty();
 
 	r = g = b = 5;
 
-	for (bit=0x8000; bit; bit>>=1)
+	for (bit=PAL_TOPBIT; bit; bit>>=1)
 	{
 		if ( (WinDraw_Pal16R&bit)&&(r) ) R[--r] = bit;
 		if ( (WinDraw_Pal16G&bit)&&(g) ) G[--g] = bit;
@@ -189,11 +205,12 @@ void Pal_ChangeContrast(int num)
 		if (i&0x0004) palb |= B[1];
 		if (i&0x0002) palb |= B[0];
 		pal = palr | palb | palg;
-		palg = (uint16_t)((palg * num)/15)&Pal_G;
-		palr = (uint16_t)((palr * num)/15)&Pal_R;
-		palb = (uint16_t)((palb * num)/15)&Pal_B;
+		palg = (pixel_t)((palg * num)/15)&Pal_G;
+		palr = (pixel_t)((palr * num)/15)&Pal_R;
+		palb = (pixel_t)((palb * num)/15)&Pal_B;
 		Pal16[i] = palr | palb | palg;
 		if ((pal)&&(!Pal16[i])) Pal16[i] = B[0];
+		Pal16[i] |= PAL_FILL(Pal16[i]);
 		if (i&0x0001) Pal16[i] |= Ibit;
 	}
 
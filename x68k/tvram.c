@@ -13,6 +13,8 @@
 #include	"tvram.h"
 
 uint8_t	TVRAM[0x80000];
+static uint8_t	TVRAM_Dirty[0x80000 >> PX68KSTATE_PAGE_SHIFT];
+static PX68KPages TVRAM_Pages = { TVRAM, TVRAM_Dirty, 0x80000, 0x80000, NULL, NULL, NULL };
 static uint8_t TextDrawWork[1024*1024];
 uint8_t	TextDirtyLine[1024];
 uint8_t	Text_TrFlag[1024];
@@ -20,18 +22,34 @@ uint8_t	Text_TrFlag[1024];
 /* pattern table */
 static uint8_t TextDrawPattern[2048*4];
 
+/* Pending raster copy, in 128 byte TVRAM rows; RC_Rows is 0 when idle */
+static uint32_t RC_Src, RC_Dst, RC_Rows;
+static uint8_t RC_Planes;
+
+/* Applies the pending raster copy before a TVRAM row it covers is used */
+#define TVRAM_RCSYNC(row) \
+	if (RC_Rows && (((row) - RC_Src) < RC_Rows || ((row) - RC_Dst) < RC_Rows)) \
+		TVRAM_RCFlush()
+
 int TVRAM_StateAction(StateMem *sm, int load, int data_only)
 {
 	SFORMAT StateRegs[] = 
 	{
-		SFARRAYN(TVRAM, 524288, "MEM_TVRAM"),
+		SFPAGESN(TVRAM_Pages, "MEM_TVRAM"),
 		SFARRAY(TextDrawWork, (1024 * 1024)),
 		SFARRAY(TextDirtyLine, 1024),
 		SFARRAY(Text_TrFlag, 1024),
 
 		SFEND
 	};
-	int ret = PX68KSS_StateAction(sm, load, data_only, StateRegs, "X68K_TVRAM", false);
+	int ret;
+
+	if (load)
+		RC_Rows = 0;
+	else
+		TVRAM_RCFlush();
+
+	ret = PX68KSS_StateAction(sm, load, data_only, StateRegs, "X68K_TVRAM", false);
 
 	if (load)
 		TVRAM_SetAllDirty();
@@ -46,8 +64,11 @@ void TVRAM_Init(void)
 {
 	int i, j, bit;
 	memset(TVRAM, 0, 0x80000);
+	memset(TVRAM_Dirty, 1, sizeof(TVRAM_Dirty));
+	PX68KSS_AddPages(&TVRAM_Pages);
 	memset(TextDrawWork, 0, 1024*1024);
 	TVRAM_SetAllDirty();
+	RC_Rows = 0;
 
 	memset(TextDrawPattern, 0, 2048*4);
 	for (i=0; i<256; i++)
@@ -68,6 +89,7 @@ void TVRAM_Init(void)
 uint8_t FASTCALL TVRAM_Read(uint32_t adr)
 {
 	adr &= 0x7ffff;
+	TVRAM_RCSYNC((adr & 0x1ffff) >> 7);
 #ifndef MSB_FIRST
 	adr ^= 1;
 #endif
@@ -80,6 +102,7 @@ static INLINE void TVRAM_WriteByte(uint32_t adr, uint8_t data)
 	if (TVRAM[adr]!=data)
 	{
 		TextDirtyLine[(((adr&0x1ffff)/128)-TextScrollY)&1023] = 1;
+		TVRAM_Dirty[adr >> PX68KSTATE_PAGE_SHIFT] = 1;
 		TVRAM[adr] = data;
 	}
 }
@@ -90,6 +113,7 @@ static INLINE void TVRAM_WriteByteMask(uint32_t adr, uint8_t data)
 	if (TVRAM[adr] != data)
 	{
 		TextDirtyLine[(((adr&0x1ffff)/128)-TextScrollY)&1023] = 1;
+		TVRAM_Dirty[adr >> PX68KSTATE_PAGE_SHIFT] = 1;
 		TVRAM[adr] = data;
 	}
 }
@@ -97,6 +121,7 @@ static INLINE void TVRAM_WriteByteMask(uint32_t adr, uint8_t data)
 void FASTCALL TVRAM_Write(uint32_t adr, uint8_t data)
 {
 	adr &= 0x7ffff;
+	TVRAM_RCSYNC((adr & 0x1ffff) >> 7);
 #ifndef MSB_FIRST
 	adr ^= 1;
 #endif
@@ -150,45 +175,117 @@ void FASTCALL TVRAM_Write(uint32_t adr, uint8_t data)
 	}
 }
 
-void FASTCALL TVRAM_RCUpdate(void)
+/*
+ * Raster copies are queued and applied on demand.  A run of copies that
+ * walks through consecutive rows in the same direction is merged into one
+ * block move, and the already expanded TextDrawWork rows are moved along
+ * with the bitplanes instead of being rebuilt from TVRAM.
+ */
+void FASTCALL TVRAM_RCFlush(void)
 {
-	uint32_t adr = ((uint32_t)CRTC_Regs[0x2d]<<9);
+	static const uint32_t off[4] = { 0, 0x20000, 0x40000, 0x60000 };
+	uint32_t src = RC_Src << 10, dst = RC_Dst << 10;
+	uint32_t len = RC_Rows << 10;
+	uint32_t mask, i;
+	int bit;
 
-	/* XXX: BUG */
-	uint32_t *ptr = (uint32_t *)TextDrawPattern;
-	uint32_t *wptr = (uint32_t *)(TextDrawWork + (adr << 3));
-	uint32_t t0, t1;
-	uint32_t tadr;
-	uint8_t pat;
-	int i;
+	if (!RC_Rows)
+		return;
+	RC_Rows = 0;
 
-	for (i = 0; i < 512; i++, adr++)
-   {
-		tadr = adr ^ 1;
+	for (bit = 0; bit < 4; bit++)
+	{
+		if (RC_Planes & (1 << bit))
+		{
+			uint32_t d = (RC_Dst << 7) + off[bit];
 
-		pat = TVRAM[tadr + 0x60000];
-		t0 = ptr[(pat * 2) + 1536];
-		t1 = ptr[(pat * 2 + 1) + 1536];
+			memmove(&TVRAM[d], &TVRAM[(RC_Src << 7) + off[bit]], len >> 3);
+			memset(&TVRAM_Dirty[d >> PX68KSTATE_PAGE_SHIFT], 1,
+				((d + (len >> 3) - 1) >> PX68KSTATE_PAGE_SHIFT) - (d >> PX68KSTATE_PAGE_SHIFT) + 1);
+		}
+	}
 
-		pat = TVRAM[tadr + 0x40000];
-		t0 |= ptr[(pat * 2) + 1024];
-		t1 |= ptr[(pat * 2 + 1) + 1024];
+	if (RC_Planes == 0x0f)
+	{
+		memmove(&TextDrawWork[dst], &TextDrawWork[src], len);
+		return;
+	}
 
-		pat = TVRAM[tadr + 0x20000];
-		t0 |= ptr[(pat * 2) + 512];
-		t1 |= ptr[(pat * 2 + 1) + 512];
+	/* Only the selected planes' bits of each expanded dot are replaced */
+	mask = RC_Planes * 0x01010101;
+	if (dst < src)
+	{
+		uint32_t *d = (uint32_t *)&TextDrawWork[dst];
+		uint32_t *s = (uint32_t *)&TextDrawWork[src];
+		for (i = 0; i < (len >> 2); i++)
+			d[i] = (d[i] & ~mask) | (s[i] & mask);
+	}
+	else
+	{
+		uint32_t *d = (uint32_t *)&TextDrawWork[dst];
+		uint32_t *s = (uint32_t *)&TextDrawWork[src];
+		for (i = (len >> 2); i-- > 0; )
+			d[i] = (d[i] & ~mask) | (s[i] & mask);
+	}
+}
 
-		pat = TVRAM[tadr];
-		t0 |= ptr[(pat * 2)];
-		t1 |= ptr[(pat * 2 + 1)];
+void FASTCALL TVRAM_RasterCopy(uint32_t src, uint32_t dst, uint8_t planes)
+{
+	planes &= 0x0f;
+	src <<= 2;
+	dst <<= 2;
+
+	if (!planes || src == dst)
+		return;
 
-		*wptr++ = t0;
-		*wptr++ = t1;
+	if (RC_Rows && planes == RC_Planes)
+	{
+		/* Ascending run: safe while it never reads rows it already wrote */
+		if (src == RC_Src + RC_Rows && dst == RC_Dst + RC_Rows
+		 && (dst < src || dst - src >= RC_Rows + 4))
+		{
+			RC_Rows += 4;
+			return;
+		}
+		/* Descending run */
+		if (src + 4 == RC_Src && dst + 4 == RC_Dst
+		 && (dst > src || src - dst >= RC_Rows + 4))
+		{
+			RC_Src = src;
+			RC_Dst = dst;
+			RC_Rows += 4;
+			return;
+		}
 	}
+
+	TVRAM_RCFlush();
+	RC_Src    = src;
+	RC_Dst    = dst;
+	RC_Rows   = 4;
+	RC_Planes = planes;
+}
+
+/* Returns non-zero when both raster lines expand to the same text row. */
+int FASTCALL Text_LineMatch(uint32_t line0, uint32_t line1)
+{
+	uint32_t y0, y1;
+
+	if ((CRTC_Regs[0x29] & 0x1c) == 0x1c) {
+		line0 <<= 1;
+		line1 <<= 1;
+	}
+	y0 = (TextScrollY + line0) & 0x3ff;
+	y1 = (TextScrollY + line1) & 0x3ff;
+	TVRAM_RCSYNC(y0);
+	TVRAM_RCSYNC(y1);
+
+	return (y0 == y1) || !memcmp(TextDrawWork + (y0 << 10), TextDrawWork + (y1 << 10), 1024);
 }
 
 void FASTCALL Text_DrawLine(int opaq)
 {
+	const uint32_t dotx = WinDraw_DotX;
+	const uint32_t step = 1 << WinDraw_HShift;
 	uint32_t addr;
 	uint32_t x;
 	uint32_t off = 16;
@@ -197,27 +294,31 @@ void FASTCALL Text_DrawLine(int opaq)
 	uint32_t y = TextScrollY + VLINE;
 	if ((CRTC_Regs[0x29] & 0x1c) == 0x1c)
 		y += VLINE;
-	y = (y & 0x3ff) << 10;
+	y &= 0x3ff;
+	TVRAM_RCSYNC(y);
+	y <<= 10;
 
 	x = TextScrollX & 0x3ff;
 	addr = x + y;
-	x = (x ^ 0x3ff) + 1;
+	x = ((x ^ 0x3ff) + step) >> WinDraw_HShift;
 
 	if (opaq) {
-		for (i = 0; (i < TextDotX) && (x > 0); i++, x--, off++) {
-			t = TextDrawWork[addr++] & 0xf;
+		for (i = 0; (i < dotx) && (x > 0); i++, x--, off++) {
+			t = TextDrawWork[addr] & 0xf;
+			addr += step;
 			Text_TrFlag[off] = t ? 1 : 0;
 			BG_LineBuf[off] = TextPal[t];
 		}
-		if (i++ != TextDotX) {
-			for (; i < TextDotX; i++, off++) {
+		if (i++ != dotx) {
+			for (; i < dotx; i++, off++) {
 				BG_LineBuf[off] = TextPal[0];
 				Text_TrFlag[off] = 0;
 			}
 		}
 	} else {
-		for (i = 0; (i < TextDotX) && (x > 0); i++, x--, off++) {
-			t = TextDrawWork[addr++] & 0xf;
+		for (i = 0; (i < dotx) && (x > 0); i++, x--, off++) {
+			t = TextDrawWork[addr] & 0xf;
+			addr += step;
 			if (t) {
 				Text_TrFlag[off] |= 1;
 				BG_LineBuf[off] = TextPal[t];
@@ -15,8 +15,10 @@ void TVRAM_Cleanup(void);
 
 uint8_t FASTCALL TVRAM_Read(uint32_t adr);
 void FASTCALL TVRAM_Write(uint32_t adr, uint8_t data);
-void FASTCALL TVRAM_RCUpdate(void);
+void FASTCALL TVRAM_RasterCopy(uint32_t src, uint32_t dst, uint8_t planes);
+void FASTCALL TVRAM_RCFlush(void);
 void FASTCALL Text_DrawLine(int opaq);
+int FASTCALL Text_LineMatch(uint32_t line0, uint32_t line1);
 int TVRAM_StateAction(StateMem *sm, int load, int data_only);
 
 #endif /* _WINX68K_TVRAM_H */
@@ -6,6 +6,7 @@
 
 extern	uint8_t*	IPL;
 extern	uint8_t*  	MEM;
+extern	PX68KPages	MEM_Pages;
 extern	uint8_t*	FONT;
 extern  uint8_t    SCSIIPL[0x2000];
 extern  uint8_t    SRAM[0x4000];